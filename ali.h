@@ -508,15 +508,18 @@ AliRegion* ali_region_new(size_t capacity) {
 }
 
 void* ali_region_alloc(AliRegion* self, size_t size) {
-	if (self->count + size >= self->capacity) return NULL;
+	if (self->count + size > self->capacity) return NULL;
 	void* ptr = self->data + self->count;
 	self->count += size;
 	return ptr;
 }
 
 void* ali_arena_alloc(AliArena* self, size_t size) {
+	// Allocations bigger than a default region get a region of their own
+	size_t capacity = size > ALI_REGION_DEFAULT_CAP ? size : ALI_REGION_DEFAULT_CAP;
+
 	if (self->start == NULL) {
-		self->start = ali_region_new(ALI_REGION_DEFAULT_CAP);
+		self->start = ali_region_new(capacity);
 		self->end = self->start;
 	}
 
@@ -526,7 +529,7 @@ void* ali_arena_alloc(AliArena* self, size_t size) {
 		ptr = ali_region_alloc(region, size);
 		if (ptr == NULL) {
 			if (region->next == NULL) {
-				region->next = ali_region_new(ALI_REGION_DEFAULT_CAP);
+				region->next = ali_region_new(capacity);
 			}
 			region = region->next;
 		}
@@ -576,7 +579,7 @@ void ali_arena_free(AliArena* self) {
 }
 
 AliArenaMark ali_arena_mark(AliArena* self) {
-	return (AliArenaMark) { self->end, self->end->count };
+	return (AliArenaMark) { self->end, self->end != NULL ? self->end->count : 0 };
 }
 
 void ali_arena_rollback(AliArena* self, AliArenaMark mark) {
@@ -586,7 +589,7 @@ void ali_arena_rollback(AliArena* self, AliArenaMark mark) {
 	}
 
 	mark.r->count = mark.count;
-	for (AliRegion* r = mark.r; r != NULL; r = r->next) {
+	for (AliRegion* r = mark.r->next; r != NULL; r = r->next) {
 		r->count = 0;
 	}
 
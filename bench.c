@@ -0,0 +1,340 @@
+// Parse, lookup and serialize throughput on synthetic documents of
+// different shapes. The corpus is generated from a fixed seed, so numbers
+// from different builds are comparable.
+#include <stdio.h>
+#include <stdlib.h>
+
+// Count every allocation made through ali.h and json.h
+static size_t bench_allocations = 0;
+
+static void* bench_malloc(size_t size) {
+    bench_allocations++;
+    return malloc(size);
+}
+
+static void* bench_realloc(void* ptr, size_t size) {
+    bench_allocations++;
+    return realloc(ptr, size);
+}
+
+#define ALI_MALLOC bench_malloc
+#define ALI_REALLOC bench_realloc
+#define ALI_REMOVE_PREFIX
+#define ALI_IMPLEMENTATION
+#include "ali.h"
+
+#define JSON_IMPLEMENTATION
+#include "json.h"
+
+#define BENCH_ROUNDS 5
+#define BENCH_CORPUS_SIZE (4 << 20)
+#define BENCH_DEPTH 64
+
+#define BENCH_MIN_LEN (1 << 10)
+#define BENCH_MAX_LEN (1 << 16)
+
+#define BENCH_DOCUMENTS (1 << 16)
+
+static AliXoshiro256ppState bench_rng;
+
+static uint64_t bench_rand(uint64_t n) {
+    return ali_xoshiro256pp_next(&bench_rng) % n;
+}
+
+static void bench_push_number(AliSb* sb) {
+    char buffer[32];
+    size_t len;
+    if (bench_rand(2) == 0) {
+        len = snprintf(buffer, sizeof(buffer), "%lld", (long long)bench_rand(1ull << 53) - (1ll << 52));
+    } else {
+        double number = (double)ali_xoshiro256pp_next(&bench_rng) / (double)UINT64_MAX;
+        len = json_format_number(buffer, number * 1e6);
+    }
+    json_sb_push(sb, buffer, len);
+}
+
+static void bench_push_string(AliSb* sb, size_t max_len) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 _-";
+    size_t len = 1 + bench_rand(max_len);
+    sb_push_strs(sb, "\"");
+    for (size_t i = 0; i < len; ++i) {
+        if (bench_rand(32) == 0) {
+            sb_push_strs(sb, bench_rand(2) == 0 ? "\\n" : "\\\"");
+        } else {
+            char c = alphabet[bench_rand(sizeof(alphabet) - 1)];
+            json_sb_push(sb, &c, 1);
+        }
+    }
+    sb_push_strs(sb, "\"");
+}
+
+static void bench_push_record(AliSb* sb, size_t id) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%zu", id);
+    sb_push_strs(sb, "{\"id\":", buffer, ",\"title\":");
+    bench_push_string(sb, 24);
+    sb_push_strs(sb, ",\"price\":");
+    bench_push_number(sb);
+    sb_push_strs(sb, ",\"in_stock\":", bench_rand(2) ? "true" : "false", ",\"tags\":[");
+    bench_push_string(sb, 8);
+    sb_push_strs(sb, ",");
+    bench_push_string(sb, 8);
+    sb_push_strs(sb, "],\"dimensions\":{\"width\":");
+    bench_push_number(sb);
+    sb_push_strs(sb, ",\"height\":");
+    bench_push_number(sb);
+    sb_push_strs(sb, "}}");
+}
+
+typedef enum {
+    BENCH_NUMBERS,
+    BENCH_STRINGS,
+    BENCH_NESTED,
+    BENCH_WIDE,
+    BENCH_RECORDS,
+    BENCH_SHAPES_COUNT,
+}BenchShape;
+
+static const char* bench_shape_names[BENCH_SHAPES_COUNT] = {
+    [BENCH_NUMBERS] = "numbers",
+    [BENCH_STRINGS] = "strings",
+    [BENCH_NESTED] = "nested",
+    [BENCH_WIDE] = "wide",
+    [BENCH_RECORDS] = "records",
+};
+
+static void bench_generate(AliSb* sb, BenchShape shape) {
+    sb_push_strs(sb, shape == BENCH_WIDE ? "{" : "[");
+    for (size_t i = 0; sb->count < BENCH_CORPUS_SIZE; ++i) {
+        if (i > 0) sb_push_strs(sb, ",");
+        switch (shape) {
+            case BENCH_NUMBERS:
+                bench_push_number(sb);
+                break;
+            case BENCH_STRINGS:
+                bench_push_string(sb, 64);
+                break;
+            case BENCH_NESTED: {
+                size_t depth = 1 + bench_rand(BENCH_DEPTH);
+                for (size_t d = 0; d < depth; ++d) sb_push_strs(sb, d % 2 ? "[" : "{\"a\":");
+                bench_push_number(sb);
+                for (size_t d = depth; d-- > 0;) sb_push_strs(sb, d % 2 ? "]" : "}");
+            } break;
+            case BENCH_WIDE: {
+                char key[32];
+                snprintf(key, sizeof(key), "\"key%zu\":", i);
+                sb_push_strs(sb, key);
+                bench_push_number(sb);
+            } break;
+            case BENCH_RECORDS:
+                bench_push_record(sb, i);
+                break;
+            case BENCH_SHAPES_COUNT:
+                ALI_UNREACHABLE();
+        }
+    }
+    sb_push_strs(sb, shape == BENCH_WIDE ? "}" : "]");
+}
+
+// ali_measure keeps the name pointers until the measurements are printed
+static char bench_measure_names[BENCH_SHAPES_COUNT][3][32];
+
+static void bench_report(const char* shape, const char* op, size_t bytes, double best, size_t allocations, size_t arena_used) {
+    printf("%-8s %-8s %10.1f %12zu %12zu\n", shape, op, bytes / best / 1e6, allocations, arena_used);
+}
+
+// Looks up every key of the wide object, or the id of every record
+static size_t bench_find(BenchShape shape, JsonValue* value) {
+    size_t found = 0;
+    if (shape == BENCH_WIDE) {
+        JsonObject* object = json_value_as_object(value);
+        char key[32];
+        for (size_t i = 0; i < object->len; ++i) {
+            snprintf(key, sizeof(key), "key%zu", i);
+            found += json_object_find_value(object, key) != NULL;
+        }
+    } else if (shape == BENCH_RECORDS) {
+        JsonArray* array = json_value_as_array(value);
+        for (size_t i = 0; i < array->len; ++i) {
+            found += json_object_find_value(json_value_as_object(&array->items[i]), "id") != NULL;
+        }
+    }
+    return found;
+}
+
+static int bench_shape(BenchShape shape) {
+    const char* name = bench_shape_names[shape];
+    char* parse_name = bench_measure_names[shape][0];
+    char* find_name = bench_measure_names[shape][1];
+    char* stringify_name = bench_measure_names[shape][2];
+    snprintf(parse_name, sizeof(bench_measure_names[shape][0]), "%s/parse", name);
+    snprintf(find_name, sizeof(bench_measure_names[shape][1]), "%s/find", name);
+    snprintf(stringify_name, sizeof(bench_measure_names[shape][2]), "%s/stringify", name);
+
+    AliSb corpus = {0};
+    bench_generate(&corpus, shape);
+
+    AliArena arena = {0};
+    AliSb out = {0};
+    double parse_best = 0, find_best = 0, stringify_best = 0;
+    size_t parse_allocations = 0, stringify_allocations = 0, arena_used = 0;
+
+    for (size_t round = 0; round < BENCH_ROUNDS; ++round) {
+        arena_reset(&arena);
+        JsonLexer lexer = json_lexer_with_arena(corpus.data, corpus.count, &arena);
+        JsonValue value;
+
+        size_t allocations = bench_allocations;
+        double start = ali_get_now();
+        ali_measure_start(parse_name);
+        if (!json_lexer_parse_value(&lexer, &value)) return 1;
+        ali_measure_end(parse_name);
+        double elapsed = ali_get_now() - start;
+        if (round == 0 || elapsed < parse_best) parse_best = elapsed;
+        parse_allocations = bench_allocations - allocations;
+        if (json_arena_used(&arena) > arena_used) arena_used = json_arena_used(&arena);
+
+        if (shape == BENCH_WIDE || shape == BENCH_RECORDS) {
+            start = ali_get_now();
+            ali_measure_start(find_name);
+            if (bench_find(shape, &value) == 0) return 1;
+            ali_measure_end(find_name);
+            elapsed = ali_get_now() - start;
+            if (round == 0 || elapsed < find_best) find_best = elapsed;
+        }
+
+        out.count = 0;
+        allocations = bench_allocations;
+        start = ali_get_now();
+        ali_measure_start(stringify_name);
+        json_stringify_sb(&out, &value);
+        ali_measure_end(stringify_name);
+        elapsed = ali_get_now() - start;
+        if (round == 0 || elapsed < stringify_best) stringify_best = elapsed;
+        stringify_allocations = bench_allocations - allocations;
+
+        json_lexer_free(&lexer);
+    }
+
+    bench_report(name, "parse", corpus.count, parse_best, parse_allocations, arena_used);
+    if (find_best > 0) bench_report(name, "find", corpus.count, find_best, 0, 0);
+    bench_report(name, "stringify", out.count, stringify_best, stringify_allocations, 0);
+
+    arena_free(&arena);
+    sb_free(&out);
+    sb_free(&corpus);
+    return 0;
+}
+
+// With linear parsing the ns/elem column stays flat, with quadratic
+// parsing it doubles together with the element count.
+static int bench_scaling(void) {
+    AliArena arena = {0};
+    printf("\n%10s %12s %10s\n", "elements", "seconds", "ns/elem");
+
+    for (size_t n = BENCH_MIN_LEN; n <= BENCH_MAX_LEN; n *= 2) {
+        AliSb sb = {0};
+        sb_push_strs(&sb, "[");
+        for (size_t i = 0; i < n; ++i) {
+            sb_push_strs(&sb, i > 0 ? ",{\"id\":" : "{\"id\":", temp_sprintf("%zu", i), "}");
+            temp_reset();
+        }
+        sb_push_strs(&sb, "]");
+
+        double best = 0;
+        for (size_t round = 0; round < BENCH_ROUNDS; ++round) {
+            arena_reset(&arena);
+            JsonLexer lexer = json_lexer_with_arena(sb.data, sb.count, &arena);
+            JsonValue value;
+
+            double start = ali_get_now();
+            if (!json_lexer_parse_value(&lexer, &value)) return 1;
+            double elapsed = ali_get_now() - start;
+
+            if (json_value_as_array(&value)->len != n) return 1;
+            json_lexer_free(&lexer);
+            if (round == 0 || elapsed < best) best = elapsed;
+        }
+
+        printf("%10zu %12.6f %10.1f\n", n, best, best * 1e9 / n);
+        sb_free(&sb);
+    }
+
+    arena_free(&arena);
+    return 0;
+}
+
+static bool bench_document_count(void* user, size_t index, JsonValue* value) {
+    (void)index;
+    *(size_t*)user += json_value_as_object(value) != NULL;
+    return true;
+}
+
+// Many small records, each in a buffer of its own, parsed with a new lexer
+// per document and with one lexer that is reset between them.
+static int bench_documents(void) {
+    AliSb corpus = {0};
+    size_t* ends = malloc(BENCH_DOCUMENTS * sizeof(*ends));
+    for (size_t i = 0; i < BENCH_DOCUMENTS; ++i) {
+        bench_push_record(&corpus, i);
+        ends[i] = corpus.count;
+    }
+    AliSv* documents = malloc(BENCH_DOCUMENTS * sizeof(*documents));
+    for (size_t i = 0; i < BENCH_DOCUMENTS; ++i) {
+        size_t start = i > 0 ? ends[i - 1] : 0;
+        documents[i] = ali_sv_from_parts(corpus.data + start, ends[i] - start);
+    }
+
+    printf("\n%-8s %10s %12s\n", "lexer", "ns/doc", "allocs/doc");
+    double fresh_best = 0, reused_best = 0;
+    size_t fresh_allocations = 0, reused_allocations = 0;
+    JsonLexer reused = json_lexer(NULL, 0);
+    for (size_t round = 0; round < BENCH_ROUNDS; ++round) {
+        size_t allocations = bench_allocations;
+        double start = ali_get_now();
+        for (size_t i = 0; i < BENCH_DOCUMENTS; ++i) {
+            JsonLexer lexer = json_lexer(documents[i].start, documents[i].len);
+            JsonValue value;
+            if (!json_lexer_parse_value(&lexer, &value)) return 1;
+            json_lexer_free(&lexer);
+        }
+        double elapsed = ali_get_now() - start;
+        if (round == 0 || elapsed < fresh_best) fresh_best = elapsed;
+        fresh_allocations = bench_allocations - allocations;
+
+        size_t parsed = 0;
+        allocations = bench_allocations;
+        start = ali_get_now();
+        if (json_lexer_parse_many(&reused, documents, BENCH_DOCUMENTS, bench_document_count, &parsed) != BENCH_DOCUMENTS) return 1;
+        elapsed = ali_get_now() - start;
+        if (parsed != BENCH_DOCUMENTS) return 1;
+        if (round == 0 || elapsed < reused_best) reused_best = elapsed;
+        reused_allocations = bench_allocations - allocations;
+    }
+
+    printf("%-8s %10.1f %12.3f\n", "fresh", fresh_best * 1e9 / BENCH_DOCUMENTS, (double)fresh_allocations / BENCH_DOCUMENTS);
+    printf("%-8s %10.1f %12.3f\n", "reused", reused_best * 1e9 / BENCH_DOCUMENTS, (double)reused_allocations / BENCH_DOCUMENTS);
+
+    json_lexer_free(&reused);
+    free(documents);
+    free(ends);
+    sb_free(&corpus);
+    return 0;
+}
+
+int main(void) {
+    uint64_t seed[4] = { 0x9e3779b97f4a7c15ull, 0xbf58476d1ce4e5b9ull, 0x94d049bb133111ebull, 0x2545f4914f6cdd1dull };
+    ali_xoshiro256pp_seed(&bench_rng, seed);
+
+    printf("%-8s %-8s %10s %12s %12s\n", "shape", "op", "MB/s", "allocations", "arena bytes");
+    for (BenchShape shape = 0; shape < BENCH_SHAPES_COUNT; ++shape) {
+        if (bench_shape(shape) != 0) return 1;
+    }
+
+    if (bench_scaling() != 0) return 1;
+    if (bench_documents() != 0) return 1;
+
+    printf("\n");
+    ali_print_measurements();
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Parses the same document on 1..N threads at once, every thread with its
+// own lexer and arena. Throughput should grow with the thread count until
+// the cores (or memory bandwidth) run out.
+#define ALI_REMOVE_PREFIX
+#define ALI_IMPLEMENTATION
+#include "ali.h"
+
+#define JSON_IMPLEMENTATION
+#include "json.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#define BENCH_PRODUCTS 20000
+#define BENCH_ROUNDS 20
+#define BENCH_MAX_THREADS 64
+
+typedef struct {
+    const AliSb* document;
+    bool ok;
+}Worker;
+
+void* worker_run(void* arg) {
+    Worker* worker = arg;
+    AliArena arena = {0};
+
+    worker->ok = true;
+    for (size_t round = 0; round < BENCH_ROUNDS; ++round) {
+        JsonLexer lexer = json_lexer_with_arena(worker->document->data, worker->document->count, &arena);
+        JsonValue value;
+        if (!json_lexer_parse_value(&lexer, &value)) worker->ok = false;
+        json_lexer_free(&lexer);
+        arena_reset(&arena);
+    }
+
+    arena_free(&arena);
+    return NULL;
+}
+
+int main(void) {
+    AliSb sb = {0};
+    sb_push_strs(&sb, "{\"products\":[");
+    for (size_t i = 0; i < BENCH_PRODUCTS; ++i) {
+        sb_push_strs(&sb, i > 0 ? "," : "", temp_sprintf(
+            "{\"id\":%zu,\"title\":\"product %zu\",\"price\":%zu.5,\"stock\":%zu,\"available\":true}",
+            i, i, i % 1000, i % 77));
+        temp_reset();
+    }
+    sb_push_strs(&sb, "]}");
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = cpus > 0 ? (size_t)cpus : 1;
+    if (max_threads > BENCH_MAX_THREADS) max_threads = BENCH_MAX_THREADS;
+    if (max_threads < 4) max_threads = 4;
+
+    printf("%8s %12s %10s\n", "threads", "MB/s", "speedup");
+
+    double single = 0;
+    for (size_t n = 1; n <= max_threads; n *= 2) {
+        pthread_t threads[BENCH_MAX_THREADS];
+        Worker workers[BENCH_MAX_THREADS];
+
+        double start = ali_get_now();
+        for (size_t i = 0; i < n; ++i) {
+            workers[i] = (Worker) { .document = &sb };
+            pthread_create(&threads[i], NULL, worker_run, &workers[i]);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            pthread_join(threads[i], NULL);
+            if (!workers[i].ok) return 1;
+        }
+        double elapsed = ali_get_now() - start;
+
+        double mbps = (double)sb.count * BENCH_ROUNDS * n / elapsed / (1 << 20);
+        if (n == 1) single = mbps;
+        printf("%8zu %12.1f %10.2f\n", n, mbps, mbps / single);
+    }
+
+    sb_free(&sb);
+    return 0;
+}
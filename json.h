@@ -2,6 +2,24 @@
 #define JSON_H_
 
 #include <stddef.h>
+#include "ali.h"
+
+// Integer literals that fit an int64_t are parsed as JSON_INTEGER values
+// instead of JSON_NUMBER, so large ids keep every digit.
+#ifndef JSON_INTEGERS
+#define JSON_INTEGERS 0
+#endif // JSON_INTEGERS
+
+// Parsed strings of up to this many bytes are stored inside their
+// JsonValue instead of the arena. Up to 31 fit without making JsonValue
+// any larger, 0 stores every string in the arena.
+#ifndef JSON_INLINE_STRING_MAX
+#define JSON_INLINE_STRING_MAX 0
+#endif // JSON_INLINE_STRING_MAX
+
+#if JSON_INLINE_STRING_MAX > 254
+#error "JSON_INLINE_STRING_MAX must be at most 254"
+#endif
 
 typedef enum {
     JSON_NUMBER,
@@ -9,48 +27,73 @@ typedef enum {
     JSON_STRING,
     JSON_ARRAY,
     JSON_OBJECT,
+    JSON_NULL,
+    JSON_INTEGER,
 }JsonValueType;
 
+typedef struct JsonValue JsonValue;
 typedef struct JsonObjectItem JsonObjectItem;
-typedef struct JsonArrayNode JsonArrayNode;
 
+// Arrays and objects store their children contiguously in the json arena,
+// so indexed access is O(1) and iteration is linear over memory.
 typedef struct {
     size_t len;
-    JsonArrayNode* next;
+    size_t capacity;
+    JsonValue* items;
 }JsonArray;
 
+// Open addressing table over an object's items. Objects with at least
+// JSON_OBJECT_INDEX_THRESHOLD keys get one when they are parsed.
+typedef struct {
+    uint32_t hash;
+    uint32_t index; // item index + 1, 0 marks an empty slot
+}JsonObjectIndexSlot;
+
+typedef struct {
+    size_t capacity; // power of two
+    JsonObjectIndexSlot slots[];
+}JsonObjectIndex;
+
 typedef struct {
     size_t len;
-    JsonObjectItem* next;
+    size_t capacity;
+    JsonObjectItem* items;
+    JsonObjectIndex* index;
 }JsonObject;
 
 typedef union {
     double number;
+    int64_t integer;
     bool boolean;
-    char* string;
+    AliSv string;
     JsonObject object;
     JsonArray array;
+#if JSON_INLINE_STRING_MAX > 0
+    char inline_string[JSON_INLINE_STRING_MAX + 1]; // NUL terminated
+#endif // JSON_INLINE_STRING_MAX
 }JsonValueAs;
 
-typedef struct {
+struct JsonValue {
     JsonValueType type;
+#if JSON_INLINE_STRING_MAX > 0
+    // Length + 1 of a string in `as.inline_string`, 0 when it's in `as.string`
+    uint8_t inline_len;
+#endif // JSON_INLINE_STRING_MAX
     JsonValueAs as;
-}JsonValue;
-
-struct JsonObjectItem {
-    char* key;
-    JsonValue value;
-    JsonObjectItem* next;
 };
 
-struct JsonArrayNode {
+// Strings and keys carry their length. They are NUL terminated unless
+// they were parsed with JSON_PARSE_VIEWS.
+struct JsonObjectItem {
+    AliSv key;
     JsonValue value;
-    JsonArrayNode* next;
 };
 
 JsonValue json_value_string(char* string);
 JsonValue json_value_number(double number);
 JsonValue json_value_boolean(bool boolean);
+JsonValue json_value_integer(int64_t integer);
+JsonValue json_value_null(void);
 JsonValue json_value_array(void);
 JsonValue json_value_object(void);
 
@@ -58,51 +101,625 @@ JsonValue* json_array_get_item(JsonArray* array, size_t index);
 JsonValue* json_object_get_item(JsonObject* object, size_t index);
 
 JsonValue* json_object_find_value(JsonObject* object, char* key);
+void json_object_build_index(AliArena* arena, JsonObject* object);
 
 double* json_value_as_number(JsonValue* value);
+int64_t* json_value_as_integer(JsonValue* value);
+// NULL for strings stored inline, json_value_as_sv reads every string
 char** json_value_as_string(JsonValue* value);
+AliSv json_value_as_sv(JsonValue* value);
 bool* json_value_as_boolean(JsonValue* value);
 JsonObject* json_value_as_object(JsonValue* value);
 JsonArray* json_value_as_array(JsonValue* value);
 
+// Deep copy into `arena`, with every string copied too. The nodes of the
+// copy are allocated in depth first order, so a subtree sits in one run
+// of memory.
+JsonValue json_value_clone(AliArena* arena, JsonValue* value);
+// Objects are equal when they have the same keys with equal values, in
+// any order. Integers equal the numbers of the same value.
+bool json_value_equal(JsonValue* a, JsonValue* b);
+// Equal values hash the same, so objects hash independently of key order.
+uint64_t json_value_hash(JsonValue* value);
+
+// Writes the whole document to stdout with a single fwrite.
 void json_stringify(JsonValue* value);
+// Appends the document to `sb`.
+void json_stringify_sb(AliSb* sb, JsonValue* value);
+
+typedef enum {
+    // Strings and keys point into the lexer's content instead of being
+    // copied into the arena. They are not NUL terminated and live only as
+    // long as the content buffer does.
+    JSON_PARSE_VIEWS = 1 << 0,
+    // Keys, and string values of up to JSON_INTERN_MAX_LEN bytes, that
+    // repeat until the lexer is freed or reset share one copy.
+    JSON_PARSE_INTERN = 1 << 1,
+}JsonParseFlags;
+
+// Set of canonical strings. The strings live in the arena they were first
+// interned into, so the table must not outlive a reset of that arena.
+typedef struct {
+    AliSv string;
+    uint32_t hash;
+}JsonInternSlot;
+
+typedef struct {
+    JsonInternSlot* slots;
+    size_t capacity;
+    size_t len;
+}JsonIntern;
+
+#ifdef JSON_STATS
+#define JSON_VALUE_TYPE_COUNT (JSON_INTEGER + 1)
+
+// Costs of the parses that went through one lexer. Only collected when
+// compiled with JSON_STATS, the counters add up across parses.
+typedef struct {
+    size_t parses;
+    size_t bytes; // input consumed
+    size_t nodes[JSON_VALUE_TYPE_COUNT]; // values by JsonValueType
+    size_t max_depth;
+    size_t string_bytes; // string and key bytes copied into the arena
+    size_t arena_bytes; // arena bytes in use after the last parse
+    size_t arena_peak; // most arena bytes in use after any parse
+    size_t scratch_peak; // most bytes on the scratch stack
+
+    double parse_seconds;
+    // Part of parse_seconds spent copying finished containers into the
+    // arena and indexing them
+    double commit_seconds;
+}JsonStats;
+#endif // JSON_STATS
+
+// Bytes allocated from `arena` since it was created or last reset
+size_t json_arena_used(AliArena* arena);
+
+// Copies `string` into `arena` unless an equal string was interned before.
+AliSv json_intern(JsonIntern* intern, AliArena* arena, const char* string, size_t len);
+void json_intern_free(JsonIntern* intern);
+// Forgets every string but keeps the slots for the next strings.
+void json_intern_clear(JsonIntern* intern);
+// Compares key pointers only, for keys interned in the same table as `key`.
+JsonValue* json_object_find_interned(JsonObject* object, AliSv key);
+
+// Input file. Mapped read-only where the platform supports it, so the
+// parser runs straight over the page cache, and read into memory otherwise.
+typedef struct {
+    const char* data;
+    size_t size;
+    bool mapped;
+}JsonFile;
+
+bool json_file_open(JsonFile* file, const char* path);
+void json_file_close(JsonFile* file);
+
+typedef enum {
+    JSON_ERROR_NONE,
+    JSON_ERROR_EOF, // the input ended inside a value
+    JSON_ERROR_UNEXPECTED_CHAR,
+    JSON_ERROR_NUMBER,
+    JSON_ERROR_TYPE, // a decoded value doesn't fit its field
+    JSON_ERROR_CALLBACK, // a callback stopped the parse
+    JSON_ERROR_DEPTH, // more than JSON_MAX_DEPTH nested containers
+    JSON_ERROR_STRING, // invalid escape or control char in a string
+    JSON_ERROR_UTF8,
+}JsonErrorCode;
+
+// Why and where a parse failed. Nothing is printed, the line and column
+// are only worked out when asked for.
+typedef struct {
+    JsonErrorCode code;
+    size_t offset; // bytes from the start of the content
+    char expected; // the char that was required, 0 if several would do
+}JsonError;
+
+const char* json_error_message(JsonErrorCode code);
+// 1-based line and byte column of `offset` in `content_start`
+void json_error_position(const char* content_start, size_t offset, size_t* line, size_t* column);
 
 typedef struct {
     const char* content_start;
     size_t content_len;
 
     const char* cursor;
+
+    // Every node, string and index of the parsed tree lives here.
+    // Free or reset the arena to drop the whole tree at once.
+    // NULL selects own_arena.
+    AliArena* arena;
+    AliArena own_arena;
+
+    // Children of the containers that are still open
+    AliSb scratch;
+    // One '[' or '{' per open container, the parser doesn't recurse
+    AliSb containers;
+    // Decoded copy of the last string that had escapes
+    AliSb unescaped;
+
+    // JsonParseFlags
+    unsigned flags;
+    // Deeper input fails with JSON_ERROR_DEPTH, 0 selects JSON_MAX_DEPTH
+    size_t max_depth;
+
+    // Set by json_lexer_from_file, closed by json_lexer_free
+    JsonFile file;
+
+    // Canonical strings for JSON_PARSE_INTERN
+    JsonIntern intern;
+
+    // Set when a parse returns false
+    JsonError error;
+
+#ifdef JSON_STATS
+    // Filled in by json_lexer_parse_value
+    JsonStats stats;
+#endif // JSON_STATS
 }JsonLexer;
 
+// Event callbacks. Callbacks that are NULL are skipped, returning false
+// from one stops the parse. Strings and keys have their escapes decoded.
+// They point into the parser's input, or into a buffer of the parser when
+// they had escapes, and are only valid during the call.
+typedef struct {
+    bool (*on_object_begin)(void* user);
+    bool (*on_object_end)(void* user);
+    bool (*on_array_begin)(void* user);
+    bool (*on_array_end)(void* user);
+    bool (*on_key)(void* user, const char* key, size_t len);
+    bool (*on_string)(void* user, const char* string, size_t len);
+    bool (*on_number)(void* user, double number);
+    // Integer literals that fit an int64_t, when set. They go to
+    // on_number otherwise.
+    bool (*on_integer)(void* user, int64_t integer);
+    bool (*on_boolean)(void* user, bool boolean);
+    bool (*on_null)(void* user);
+}JsonSax;
+
+// Consumer of JsonSax events that builds a JsonValue tree.
+typedef struct {
+    AliArena* arena;
+    // Open containers and their children
+    AliSb scratch;
+    // JsonParseFlags
+    unsigned flags;
+    // Required by JSON_PARSE_INTERN
+    JsonIntern* intern;
+    // JSON_PARSE_VIEWS keeps strings that lie in this range, the input,
+    // and copies the ones that were decoded elsewhere
+    const char* views_start;
+    const char* views_end;
+
+#ifdef JSON_STATS
+    JsonStats* stats; // optional
+    size_t depth;
+#endif // JSON_STATS
+
+    size_t top; // scratch offset of the innermost open container
+    bool done;
+    JsonValue root;
+}JsonDomBuilder;
+
+extern const JsonSax json_dom_sax;
+
+JsonDomBuilder json_dom_builder(AliArena* arena, unsigned flags);
+void json_dom_builder_free(JsonDomBuilder* builder);
+
+// A lexer only touches its own state, so different lexers can parse on
+// different threads at the same time without any locking.
+// Parses into an arena owned by the lexer, json_lexer_free releases it.
 JsonLexer json_lexer(const char* content_start, size_t content_size);
+JsonLexer json_lexer_with_arena(const char* content_start, size_t content_size, AliArena* arena);
+void json_lexer_free(JsonLexer* lexer);
+// Views made with JSON_PARSE_VIEWS stay valid until json_lexer_free.
+bool json_lexer_from_file(JsonLexer* lexer, const char* path, AliArena* arena);
 bool json_lexer_parse_value(JsonLexer* lexer, JsonValue* value);
+// Points the lexer at another input and resets its arena, which drops the
+// trees parsed so far. The arena's regions, the intern table and the
+// scratch buffers stay allocated, so a lexer that is reset for every
+// document stops allocating once it has seen the largest one.
+void json_lexer_reset(JsonLexer* lexer, const char* content_start, size_t content_size);
+// Called with the index and tree of each document. The tree lives until
+// the next document is parsed, returning false stops the parse.
+typedef bool (*JsonDocumentFn)(void* user, size_t index, JsonValue* value);
+// Parses every document, each a whole buffer holding one value, with the
+// lexer reset before each of them. Returns the index of the first
+// document that failed or whose callback returned false, with
+// `lexer->error` saying why, and `count` when there was none.
+size_t json_lexer_parse_many(JsonLexer* lexer, const AliSv* documents, size_t count, JsonDocumentFn fn, void* user);
+void json_lexer_error_position(JsonLexer* lexer, size_t* line, size_t* column);
+// Reports the next value as events without building a tree.
+bool json_lexer_parse_sax(JsonLexer* lexer, const JsonSax* sax, void* user);
+
+// Checks that the input is exactly one value, with valid escapes and
+// UTF-8 in its strings and at most `max_depth` nested containers (0
+// selects JSON_MAX_DEPTH). Unlike json_lexer_parse_value, which stops
+// after the first value, content after it fails. It fails exactly where
+// json_lexer_parse_many on the whole buffer with the same max_depth
+// would, with the same error. Nothing is allocated unless max_depth is
+// above JSON_MAX_DEPTH. `error` may be NULL.
+bool json_validate(const char* content_start, size_t content_size, size_t max_depth, JsonError* error);
+
+// Push parser for input that arrives in chunks, e.g. from a socket.
+// Chunks can be split anywhere, even inside a token. Only the bytes of a
+// token that straddles two chunks are buffered, so the input never has
+// to be held in memory as a whole.
+typedef enum {
+    JSON_STREAM_VALUE,
+    JSON_STREAM_VALUE_OR_END,
+    JSON_STREAM_KEY,
+    JSON_STREAM_KEY_OR_END,
+    JSON_STREAM_COLON,
+    JSON_STREAM_COMMA_OR_END,
+    JSON_STREAM_DONE,
+    JSON_STREAM_FAILED,
+}JsonStreamState;
+
+typedef struct {
+    // NULL sends the events to `builder`
+    const JsonSax* sax;
+    void* user;
+    AliArena* arena;
+    AliArena own_arena;
+    JsonDomBuilder builder;
+
+    // One '[' or '{' per open container
+    AliSb containers;
+
+    JsonStreamState state;
+    AliSb carry; // start of a token that continues in the next chunk
+    AliSb unescaped;
+}JsonStream;
+
+// Builds the tree in `arena`, or in an arena owned by the stream if NULL.
+// Strings are always copied.
+JsonStream json_stream(AliArena* arena);
+// Reports events to `sax` instead of building a tree.
+JsonStream json_stream_sax(const JsonSax* sax, void* user);
+bool json_stream_feed(JsonStream* stream, const char* chunk, size_t chunk_size);
+// Call once the input has ended. Returns the finished tree unless the
+// stream reports events, `value` may be NULL then.
+bool json_stream_finish(JsonStream* stream, JsonValue* value);
+void json_stream_free(JsonStream* stream);
+
+// Newline delimited JSON: one value per line, blank lines are skipped.
+// Records are called back in input order with their 1-based line number.
+// The value lives in an arena that is reset once its batch has been
+// delivered, so copy out what has to outlive the callback. Returning
+// false from the callback stops the parse.
+typedef bool (*JsonRecordFn)(void* user, size_t line, JsonValue* value);
+
+typedef struct {
+    const char* content_start;
+    size_t content_len;
+
+    // Batches parsed at the same time, each worker has its own arena.
+    // 0 and 1 parse on the calling thread, so do builds with JSON_NO_THREADS.
+    size_t threads;
+    // Input bytes per batch, 0 selects JSON_NDJSON_BATCH_SIZE
+    size_t batch_size;
+    // JsonParseFlags
+    unsigned flags;
+
+    // Line of the first invalid record when parsing fails, and what was
+    // wrong with it. A callback that stops the parse only sets the code.
+    size_t error_line;
+    JsonError error;
+}JsonNdjson;
+
+JsonNdjson json_ndjson(const char* content_start, size_t content_size);
+bool json_ndjson_parse(JsonNdjson* ndjson, JsonRecordFn fn, void* user);
+
+// Same result as json_lexer_parse_value, but the elements of arrays of at
+// least JSON_PARALLEL_MIN_SIZE bytes are split into `threads` ranges that
+// are parsed at the same time. Arrays nested in such elements are parsed
+// serially. With JSON_PARSE_INTERN the strings end up in `lexer->intern`
+// as with a serial parse.
+bool json_lexer_parse_parallel(JsonLexer* lexer, JsonValue* value, size_t threads);
+
+// Flat read-only document: every value is one or two 64 bit words in
+// document order. The top 8 bits of a word hold its tag, the rest a
+// payload: the word after the matching close for '[' and '{', the child
+// count for ']' and '}', and an offset into `strings` for strings. Numbers
+// and integers keep their bits in the following word. Object items are a key string
+// followed by the value.
+typedef struct {
+    const uint64_t* words;
+    size_t len;
+    // Length prefixed, NUL terminated copies of every string and key
+    const char* strings;
+    size_t strings_len;
+}JsonTape;
+
+// A value on a tape, `tape` is NULL when there is none. Every function
+// takes such a ref: lookups on it find nothing again and json_tape_type
+// says JSON_NULL.
+typedef struct {
+    const JsonTape* tape;
+    size_t index;
+}JsonTapeRef;
+
+// Builds the tape in the lexer's arena.
+bool json_lexer_parse_tape(JsonLexer* lexer, JsonTape* tape);
+
+JsonTapeRef json_tape_root(const JsonTape* tape);
+JsonValueType json_tape_type(JsonTapeRef ref);
+bool json_tape_as_number(JsonTapeRef ref, double* number);
+bool json_tape_as_integer(JsonTapeRef ref, int64_t* integer);
+// The start is NULL if `ref` is not a string
+AliSv json_tape_as_sv(JsonTapeRef ref);
+bool json_tape_as_boolean(JsonTapeRef ref, bool* boolean);
+// Number of elements or items, 0 for scalars
+size_t json_tape_len(JsonTapeRef ref);
+// First element or key of a container, and the value after `ref` inside
+// its container. Both return no value at the end.
+JsonTapeRef json_tape_first(JsonTapeRef ref);
+JsonTapeRef json_tape_next(JsonTapeRef ref);
+JsonTapeRef json_tape_array_get_item(JsonTapeRef array, size_t index);
+JsonTapeRef json_tape_object_find_value(JsonTapeRef object, char* key);
+
+// Position of a value in unparsed input. Moving to an item steps over the
+// values before it by matching quotes and brackets, without parsing or
+// allocating them, so skipped values are not checked either. `start` is
+// NULL when there is no value, and every function takes such a cursor:
+// lookups on it find nothing and json_cursor_type says JSON_NULL, so
+// lookups can be chained. Keys are compared as they are written, without
+// decoding escapes.
+typedef struct {
+    const char* start;
+    const char* end; // end of the input
+}JsonCursor;
+
+JsonCursor json_cursor(const char* content_start, size_t content_size);
+JsonValueType json_cursor_type(JsonCursor cursor);
+bool json_cursor_as_number(JsonCursor cursor, double* number);
+// The string as written in the input, escapes are not decoded
+AliSv json_cursor_as_sv(JsonCursor cursor);
+bool json_cursor_as_boolean(JsonCursor cursor, bool* boolean);
+// Same order as on a tape, keys are followed by their value.
+JsonCursor json_cursor_first(JsonCursor cursor);
+JsonCursor json_cursor_next(JsonCursor cursor);
+JsonCursor json_cursor_get_item(JsonCursor array, size_t index);
+JsonCursor json_cursor_find_value(JsonCursor object, char* key);
+// Parses just the value under the cursor into a tree in `arena`, which
+// the tree lives in. Fails without an arena, since the lexer's own would
+// be freed before the tree could be used.
+bool json_cursor_parse(JsonCursor cursor, AliArena* arena, JsonValue* value);
+
+// Compiled query, reusable on any number of trees and inputs.
+typedef struct {
+    // Object key, also used as array index when `has_index` is set
+    char* key;
+    size_t key_len;
+    uint32_t hash;
+    size_t index;
+    bool has_index;
+    // Matches every element or item value
+    bool wildcard;
+}JsonPathStep;
+
+typedef struct {
+    JsonPathStep* steps;
+    size_t len;
+}JsonPath;
+
+// RFC 6901 JSON Pointer, e.g. "/products/0/id".
+bool json_path_compile_pointer(AliArena* arena, const char* pointer, JsonPath* path);
+// Dotted path with indices and wildcards, e.g. "products[0].id" or "products.*.id".
+bool json_path_compile(AliArena* arena, const char* source, JsonPath* path);
+
+// First match, or NULL
+JsonValue* json_path_find(JsonValue* root, const JsonPath* path);
+JsonCursor json_path_find_cursor(JsonCursor root, const JsonPath* path);
+
+// Calls `fn` for every match in document order, returning false stops.
+typedef bool (*JsonPathFn)(void* user, JsonValue* value);
+typedef bool (*JsonPathCursorFn)(void* user, JsonCursor value);
+void json_path_each(JsonValue* root, const JsonPath* path, JsonPathFn fn, void* user);
+void json_path_each_cursor(JsonCursor root, const JsonPath* path, JsonPathCursorFn fn, void* user);
+
+// Decoding objects straight into C structs, without building a tree.
+typedef enum {
+    JSON_FIELD_NUMBER,  // double
+    JSON_FIELD_INTEGER, // int64_t, the number must be integral
+    JSON_FIELD_BOOLEAN, // bool
+    JSON_FIELD_STRING,  // AliSv, copied or viewed like tree strings
+    JSON_FIELD_OBJECT,  // struct described by `schema`
+}JsonFieldType;
+
+typedef struct JsonSchema JsonSchema;
+
+typedef struct {
+    const char* name;
+    size_t offset; // offsetof the member in the struct
+    JsonFieldType type;
+    JsonSchema* schema;
+}JsonField;
+
+#ifndef JSON_SCHEMA_SHAPE_MAX
+#define JSON_SCHEMA_SHAPE_MAX 32
+#endif // JSON_SCHEMA_SHAPE_MAX
+
+// Remembers which field each key position mapped to in the last object,
+// so objects with the same key order are matched with one compare per key.
+// The cache makes a schema unsafe to share between threads.
+struct JsonSchema {
+    const JsonField* fields;
+    size_t len;
+    uint8_t shape[JSON_SCHEMA_SHAPE_MAX]; // field index + 1, 0 when unknown
+};
+
+JsonSchema json_schema(const JsonField* fields, size_t len);
+// Keys without a field are checked and skipped, fields without a key or
+// with a null value are left untouched.
+bool json_lexer_decode(JsonLexer* lexer, JsonSchema* schema, void* out);
+// Decodes an array of objects, calling `fn` after each element is in `out`.
+typedef bool (*JsonDecodeFn)(void* user, void* out);
+bool json_lexer_decode_each(JsonLexer* lexer, JsonSchema* schema, void* out, JsonDecodeFn fn, void* user);
+
+// Binary image of a tree that is used in place, without a parse step.
+// Everything is a 64 bit word in host byte order: a header of magic, size
+// and root, then nodes referenced by words tagged like tape words. Arrays
+// are a length and one word per element, objects a length and a key and
+// a value word per item, strings a length, the bytes and a NUL. Images are
+// trusted, only the header is checked when loading.
+typedef struct {
+    const char* data;
+    size_t size;
+    JsonFile file;
+}JsonBinary;
+
+// A value in an image, `binary` is NULL when there is none. Every
+// function takes such a ref: lookups on it find nothing again and
+// json_binary_type says JSON_NULL.
+typedef struct {
+    const JsonBinary* binary;
+    uint64_t word;
+}JsonBinaryRef;
+
+void json_binary_write(AliSb* sb, JsonValue* value);
+bool json_binary_save(const char* path, JsonValue* value);
+// `data` must be 8 byte aligned and outlive the binary.
+bool json_binary_from_memory(JsonBinary* binary, const void* data, size_t size);
+bool json_binary_open(JsonBinary* binary, const char* path);
+void json_binary_close(JsonBinary* binary);
+
+JsonBinaryRef json_binary_root(const JsonBinary* binary);
+JsonValueType json_binary_type(JsonBinaryRef ref);
+bool json_binary_as_number(JsonBinaryRef ref, double* number);
+bool json_binary_as_integer(JsonBinaryRef ref, int64_t* integer);
+// The start is NULL if `ref` is not a string
+AliSv json_binary_as_sv(JsonBinaryRef ref);
+bool json_binary_as_boolean(JsonBinaryRef ref, bool* boolean);
+// Number of elements or items, 0 for scalars
+size_t json_binary_len(JsonBinaryRef ref);
+JsonBinaryRef json_binary_array_get_item(JsonBinaryRef array, size_t index);
+AliSv json_binary_object_get_key(JsonBinaryRef object, size_t index);
+JsonBinaryRef json_binary_object_get_value(JsonBinaryRef object, size_t index);
+JsonBinaryRef json_binary_object_find_value(JsonBinaryRef object, char* key);
+
+// Edits trees in place. Storage that edits give up (the items of
+// containers, their indexes and optionally strings) goes on free lists by
+// size class, and later edits reuse blocks of exactly the size they need.
+// Containers grow by doubling, so sizes repeat and a long series of edits
+// stays within the most memory it ever had live of each size, instead of
+// growing the arena. The free lists point into the arena, reset both
+// together.
+#define JSON_EDITOR_SMALL_MAX 256
+#define JSON_EDITOR_LARGE_CLASSES 64
+
+typedef struct {
+    AliArena* arena;
+    // Set when every string and key of the tree has an allocation of its
+    // own: parsed without JSON_PARSE_VIEWS and JSON_PARSE_INTERN, or made
+    // with json_editor_strndup. Strings of released values are reused then.
+    bool free_strings;
+    // small[i] holds blocks of (i + 1) * 8 bytes, larger blocks are
+    // spread over `large` by their size
+    void* small[JSON_EDITOR_SMALL_MAX / 8];
+    void* large[JSON_EDITOR_LARGE_CLASSES];
+}JsonEditor;
+
+JsonEditor json_editor(AliArena* arena);
+void* json_editor_alloc(JsonEditor* editor, size_t size);
+void json_editor_free(JsonEditor* editor, void* block, size_t size);
+char* json_editor_strndup(JsonEditor* editor, const char* string, size_t len);
+// Gives the storage below `value` back to the editor, the tree must not
+// share it with another one.
+void json_editor_release(JsonEditor* editor, JsonValue* value);
+
+// Out of range indexes fail. Replaced and removed values are released.
+bool json_array_insert(JsonEditor* editor, JsonArray* array, size_t index, JsonValue value);
+bool json_array_replace(JsonEditor* editor, JsonArray* array, size_t index, JsonValue value);
+bool json_array_remove(JsonEditor* editor, JsonArray* array, size_t index);
+
+// Keys are copied. Inserting a key that exists fails, replacing or
+// removing a missing one too.
+bool json_object_insert(JsonEditor* editor, JsonObject* object, size_t index, const char* key, JsonValue value);
+bool json_object_replace(JsonEditor* editor, JsonObject* object, const char* key, JsonValue value);
+bool json_object_remove(JsonEditor* editor, JsonObject* object, const char* key);
+// Replaces the value of `key`, or appends it
+void json_object_set(JsonEditor* editor, JsonObject* object, const char* key, JsonValue value);
 
 #endif // JSON_H_
 
 #ifdef JSON_IMPLEMENTATION
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(JSON_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define JSON_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // JSON_NO_MMAP
+
+#if !defined(JSON_NO_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#define JSON_HAVE_THREADS
+#include <pthread.h>
+#endif // JSON_NO_THREADS
+
+// The scanners below classify 64 bytes per step with the widest vector
+// unit the translation unit is compiled for (-mavx2, SSE2 on any x86_64,
+// NEON on aarch64). Define JSON_NO_SIMD to force the scalar fallback.
+#if !defined(JSON_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define JSON_SIMD_AVX2
+#elif !defined(JSON_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define JSON_SIMD_SSE2
+#elif !defined(JSON_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define JSON_SIMD_NEON
+#endif
+
+#ifndef JSON_CONTAINER_INIT_CAPACITY
+#define JSON_CONTAINER_INIT_CAPACITY 8
+#endif // JSON_CONTAINER_INIT_CAPACITY
 
-#ifndef JSON_ARENA_MAX_SIZE
-#define JSON_ARENA_MAX_SIZE (1 << 20)
-#endif // JSON_ARENA_MAX_SIZE
-uint8_t json_arena[JSON_ARENA_MAX_SIZE] = {0};
-size_t json_arena_size = 0;
+#ifndef JSON_OBJECT_INDEX_THRESHOLD
+#define JSON_OBJECT_INDEX_THRESHOLD 16
+#endif // JSON_OBJECT_INDEX_THRESHOLD
 
-size_t json_arena_stamp() {
-    return json_arena_size;
+// Sizes are rounded up so that every allocation stays 8 byte aligned.
+void* json_alloc(AliArena* arena, size_t size) {
+    return ali_arena_alloc(arena, (size + 7) & ~(size_t)7);
 }
 
-void json_arena_rewind(size_t stamp) {
-    json_arena_size = stamp;
+// Children of the containers that are still open are collected on a
+// scratch stack and copied into the arena in one go once their container
+// closes, so parsing is linear in the element count and nothing is over-allocated.
+size_t json_scratch_push(AliSb* scratch, const void* data, size_t size) {
+    ali_sb_maybe_resize(scratch, size);
+    memcpy(scratch->data + scratch->count, data, size);
+    scratch->count += size;
+    return scratch->count;
 }
 
-void* json_alloc(size_t size) {
-    void* ptr = &json_arena[json_arena_size];
-    json_arena_size += size;
-    return ptr;
+void json_sb_push(AliSb* sb, const char* data, size_t len) {
+    if (len == 0) return;
+    ali_sb_maybe_resize(sb, len);
+    memcpy(sb->data + sb->count, data, len);
+    sb->count += len;
 }
 
-char* json_strndup(const char* str, size_t len) {
-    char* copy = json_alloc(len + 1);
+// Moves everything pushed since `base` into the arena and pops it.
+void* json_scratch_commit(AliSb* scratch, AliArena* arena, size_t base) {
+    size_t size = scratch->count - base;
+    if (size == 0) return NULL;
+
+    void* items = json_alloc(arena, size);
+    memcpy(items, scratch->data + base, size);
+    scratch->count = base;
+    return items;
+}
+
+char* json_strndup(AliArena* arena, const char* str, size_t len) {
+    char* copy = json_alloc(arena, len + 1);
     memcpy(copy, str, len);
     copy[len] = 0;
     return copy;
@@ -111,7 +728,7 @@ char* json_strndup(const char* str, size_t len) {
 JsonValue json_value_string(char* string) {
     JsonValue value = {0};
     value.type = JSON_STRING;
-    value.as.string = string;
+    value.as.string = ali_sv_from_cstr(string);
     return value;
 }
 
@@ -125,10 +742,51 @@ JsonValue json_value_number(double number) {
 JsonValue json_value_boolean(bool boolean) {
     JsonValue value = {0};
     value.type = JSON_BOOLEAN;
-    value.as.number = boolean;
+    value.as.boolean = boolean;
+    return value;
+}
+
+JsonValue json_value_integer(int64_t integer) {
+    JsonValue value = {0};
+    value.type = JSON_INTEGER;
+    value.as.integer = integer;
+    return value;
+}
+
+JsonValue json_value_null(void) {
+    JsonValue value = {0};
+    value.type = JSON_NULL;
     return value;
 }
 
+// Copies the string into the value when it's short enough, returns false
+// otherwise.
+bool json_value_inline(JsonValue* value, const char* string, size_t len) {
+#if JSON_INLINE_STRING_MAX > 0
+    if (len > JSON_INLINE_STRING_MAX) return false;
+    *value = (JsonValue) {0};
+    value->type = JSON_STRING;
+    value->inline_len = (uint8_t)(len + 1);
+    memcpy(value->as.inline_string, string, len);
+    value->as.inline_string[len] = 0;
+    return true;
+#else
+    (void)value;
+    (void)string;
+    (void)len;
+    return false;
+#endif // JSON_INLINE_STRING_MAX
+}
+
+bool json_value_is_inline(JsonValue* value) {
+#if JSON_INLINE_STRING_MAX > 0
+    return value->type == JSON_STRING && value->inline_len != 0;
+#else
+    (void)value;
+    return false;
+#endif // JSON_INLINE_STRING_MAX
+}
+
 JsonValue json_value_array(void) {
     JsonValue value = {0};
     value.type = JSON_ARRAY;
@@ -141,265 +799,4605 @@ JsonValue json_value_object(void) {
     return value;
 }
 
-void json_array_append(JsonArray* array, JsonValue value) {
-    array->len++;
-    
-    if (array->next == NULL) {
-        array->next = json_alloc(sizeof(*array->next));
-        array->next->value = value;
-        array->next->next = NULL;
-    } else {
-        JsonArrayNode* cur = array->next;
-        while (cur != NULL && cur->next != NULL) cur = cur->next;
+// FNV-1a
+uint32_t json_hash_key(const char* key, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (uint8_t)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void json_object_index_insert(JsonObjectIndex* index, uint32_t hash, size_t item_index) {
+    size_t mask = index->capacity - 1;
+    size_t slot = hash & mask;
+    while (index->slots[slot].index != 0) slot = (slot + 1) & mask;
+    index->slots[slot].hash = hash;
+    index->slots[slot].index = item_index + 1;
+}
 
-        cur->next = json_alloc(sizeof(*cur->next));
-        cur->next->value = value;
-        cur->next->next = NULL;
+size_t json_object_index_capacity(size_t len) {
+    size_t capacity = 16;
+    while (capacity < len * 2) capacity *= 2;
+    return capacity;
+}
+
+size_t json_object_index_size(size_t capacity) {
+    return sizeof(JsonObjectIndex) + capacity * sizeof(JsonObjectIndexSlot);
+}
+
+void json_object_index_fill(JsonObjectIndex* index, JsonObject* object) {
+    memset(index->slots, 0, index->capacity * sizeof(JsonObjectIndexSlot));
+    for (size_t i = 0; i < object->len; ++i) {
+        AliSv key = object->items[i].key;
+        json_object_index_insert(index, json_hash_key(key.start, key.len), i);
     }
 }
 
-void json_object_append(JsonObject* object, char* key, JsonValue value) {
-    object->len++;
+void json_object_build_index(AliArena* arena, JsonObject* object) {
+    size_t capacity = json_object_index_capacity(object->len);
+    JsonObjectIndex* index = json_alloc(arena, json_object_index_size(capacity));
+    index->capacity = capacity;
+    json_object_index_fill(index, object);
+    object->index = index;
+}
 
-    if (object->next == NULL) {
-        object->next = json_alloc(sizeof(*object->next));
-        object->next->key = key;
-        object->next->value = value;
-        object->next->next = NULL;
-    } else {
-        JsonObjectItem* cur = object->next;
-        while (cur != NULL && cur->next != NULL) cur = cur->next;
+#ifndef JSON_INTERN_MAX_LEN
+#define JSON_INTERN_MAX_LEN 16
+#endif // JSON_INTERN_MAX_LEN
+
+void json_intern_grow(JsonIntern* intern) {
+    size_t capacity = intern->capacity == 0 ? 64 : intern->capacity * 2;
+    JsonInternSlot* slots = ALI_MALLOC(capacity * sizeof(*slots));
+    memset(slots, 0, capacity * sizeof(*slots));
 
-        cur->next = json_alloc(sizeof(*cur->next));
-        cur->next->key = key;
-        cur->next->value = value;
-        cur->next->next = NULL;
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < intern->capacity; ++i) {
+        JsonInternSlot slot = intern->slots[i];
+        if (slot.string.start == NULL) continue;
+
+        size_t at = slot.hash & mask;
+        while (slots[at].string.start != NULL) at = (at + 1) & mask;
+        slots[at] = slot;
     }
+
+    ALI_FREE(intern->slots);
+    intern->slots = slots;
+    intern->capacity = capacity;
 }
 
-JsonValue* json_object_get_item(JsonObject* object, size_t index) {
-    if (index > object->len) return NULL;
+AliSv json_intern(JsonIntern* intern, AliArena* arena, const char* string, size_t len) {
+    if ((intern->len + 1) * 2 > intern->capacity) json_intern_grow(intern);
 
-    JsonObjectItem* cur = object->next;
-    while (cur != NULL && index > 0) {
-        cur = cur->next;
-        index--;
+    uint32_t hash = json_hash_key(string, len);
+    size_t mask = intern->capacity - 1;
+    size_t at = hash & mask;
+    for (; intern->slots[at].string.start != NULL; at = (at + 1) & mask) {
+        JsonInternSlot* slot = &intern->slots[at];
+        if (slot->hash == hash && slot->string.len == len && memcmp(slot->string.start, string, len) == 0) return slot->string;
     }
 
-    return &cur->value;
+    // A NULL arena keeps `string` itself as the canonical copy
+    char* canonical = arena != NULL ? json_strndup(arena, string, len) : (char*)string;
+    intern->slots[at].string = ali_sv_from_parts(canonical, len);
+    intern->slots[at].hash = hash;
+    intern->len++;
+    return intern->slots[at].string;
 }
 
-JsonValue* json_array_get_item(JsonArray* array, size_t index) {
-    if (index > array->len) return NULL;
+void json_intern_free(JsonIntern* intern) {
+    ALI_FREE(intern->slots);
+    *intern = (JsonIntern) {0};
+}
 
-    JsonArrayNode* cur = array->next;
-    while (cur != NULL && index > 0) {
-        cur = cur->next;
-        index--;
+void json_intern_clear(JsonIntern* intern) {
+    // A table that one large input grew far past what the current one
+    // holds starts over, so clearing doesn't stay slow for all the small
+    // inputs after it
+    if (intern->capacity > 1024 && intern->len * 8 < intern->capacity) {
+        json_intern_free(intern);
+        return;
     }
+    if (intern->slots != NULL) memset(intern->slots, 0, intern->capacity * sizeof(*intern->slots));
+    intern->len = 0;
+}
+
+// Turn the children pushed on `scratch` since `base` into a container.
+JsonValue json_commit_array(AliSb* scratch, AliArena* arena, size_t base) {
+    JsonValue value = json_value_array();
+    value.as.array.len = (scratch->count - base) / sizeof(JsonValue);
+    value.as.array.capacity = value.as.array.len;
+    value.as.array.items = json_scratch_commit(scratch, arena, base);
+    return value;
+}
+
+JsonValue json_commit_object(AliSb* scratch, AliArena* arena, size_t base) {
+    JsonValue value = json_value_object();
+    value.as.object.len = (scratch->count - base) / sizeof(JsonObjectItem);
+    value.as.object.capacity = value.as.object.len;
+    value.as.object.items = json_scratch_commit(scratch, arena, base);
+    if (value.as.object.len >= JSON_OBJECT_INDEX_THRESHOLD) json_object_build_index(arena, &value.as.object);
+    return value;
+}
 
-    return &cur->value;
+JsonValue* json_object_get_item(JsonObject* object, size_t index) {
+    if (index >= object->len) return NULL;
+    return &object->items[index].value;
+}
+
+JsonValue* json_array_get_item(JsonArray* array, size_t index) {
+    if (index >= array->len) return NULL;
+    return &array->items[index];
 }
 
 JsonLexer json_lexer(const char* content_start, size_t content_size) {
-    JsonLexer lexer = { content_start, content_size, content_start };
-    return lexer;
+    return json_lexer_with_arena(content_start, content_size, NULL);
 }
 
-bool json_is_empty(JsonLexer* lexer) {
-    return lexer->content_start >= lexer->content_start + lexer->content_len;
+JsonLexer json_lexer_with_arena(const char* content_start, size_t content_size, AliArena* arena) {
+    JsonLexer lexer = {0};
+    lexer.content_start = content_start;
+    lexer.content_len = content_size;
+    lexer.cursor = content_start;
+    lexer.arena = arena;
+    return lexer;
 }
 
-void json_lexer_trim_left(JsonLexer* lexer) {
-    if (json_is_empty(lexer)) return;
-    while (!json_is_empty(lexer) && isspace(*lexer->cursor)) lexer->cursor++;
+void json_lexer_free(JsonLexer* lexer) {
+    ali_arena_free(&lexer->own_arena);
+    ali_sb_free(&lexer->scratch);
+    ali_sb_free(&lexer->containers);
+    ali_sb_free(&lexer->unescaped);
+    json_file_close(&lexer->file);
+    json_intern_free(&lexer->intern);
 }
 
-bool json_lexer_expect_char(JsonLexer* lexer, char c) {
-    if (json_is_empty(lexer)) {
-        fprintf(stderr, "Unexpected EOF\n");
-        return false;
+#define JSON_FILE_READ_CHUNK (64*1024)
+
+bool json_file_read(JsonFile* file, const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) return false;
+
+    char* data = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+    for (;;) {
+        if (capacity - size < JSON_FILE_READ_CHUNK) {
+            capacity = capacity == 0 ? JSON_FILE_READ_CHUNK : capacity * 2;
+            data = ALI_REALLOC(data, capacity);
+        }
+        size_t n = fread(data + size, 1, capacity - size, f);
+        size += n;
+        if (n == 0) break;
     }
-    if (*lexer->cursor != c) {
-        fprintf(stderr, "Unexpected char '%c'\n", c);
+
+    bool ok = !ferror(f);
+    fclose(f);
+    if (!ok) {
+        ALI_FREE(data);
         return false;
     }
-    lexer->cursor++;
+
+    file->data = data;
+    file->size = size;
+    file->mapped = false;
     return true;
 }
 
-bool json_lexer_parse_object_item(JsonLexer* lexer, JsonObjectItem* item);
-
-bool json_lexer_parse_value(JsonLexer* lexer, JsonValue* value) {
-    json_lexer_trim_left(lexer);
-
-    if (isdigit(*lexer->cursor) || *lexer->cursor == '.') {
-        value->type = JSON_NUMBER;
+bool json_file_open(JsonFile* file, const char* path) {
+    *file = (JsonFile) {0};
 
-        char* endptr;
-        value->as.number = strtod(lexer->cursor, &endptr);
+#ifdef JSON_HAVE_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
 
-        lexer->cursor = endptr;
-        return true;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+            // The lexer reads front to back, let the kernel read ahead aggressively
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+#endif // MADV_SEQUENTIAL
+            close(fd);
+            file->data = data;
+            file->size = st.st_size;
+            file->mapped = true;
+            return true;
+        }
     }
+    // Pipes, empty files and failed mappings are read instead
+    close(fd);
+#endif // JSON_HAVE_MMAP
 
-    if (*lexer->cursor == '"') {
-        value->type = JSON_STRING;
+    return json_file_read(file, path);
+}
 
-        const char* start = ++lexer->cursor;
-        while (!json_is_empty(lexer) && *lexer->cursor != '"') {
-            lexer->cursor++;
-        }
-        value->type = JSON_STRING;
-        value->as.string = json_strndup(start, (int)(lexer->cursor - start));
-        if (!json_lexer_expect_char(lexer, '"')) return false;
+void json_file_close(JsonFile* file) {
+#ifdef JSON_HAVE_MMAP
+    if (file->mapped) munmap((void*)file->data, file->size);
+#endif // JSON_HAVE_MMAP
+    if (!file->mapped) ALI_FREE((void*)file->data);
+    *file = (JsonFile) {0};
+}
 
-        return true;
-    }
+bool json_lexer_from_file(JsonLexer* lexer, const char* path, AliArena* arena) {
+    JsonFile file;
+    if (!json_file_open(&file, path)) return false;
 
-    if (*lexer->cursor == 'f' || *lexer->cursor == 't') {
-        size_t stamp = json_arena_stamp();
-        value->type = JSON_BOOLEAN;
+    *lexer = json_lexer_with_arena(file.data, file.size, arena);
+    lexer->file = file;
+    return true;
+}
 
-        const char* start = lexer->cursor;
-        while (!json_is_empty(lexer) && !isalpha(*lexer->cursor)) {
-            lexer->cursor++;
-        }
-        char* value_ = json_strndup(start, (int)(lexer->cursor - start));
+size_t json_arena_used(AliArena* arena) {
+    size_t used = 0;
+    for (AliRegion* r = arena->start; r != NULL; r = r->next) used += r->count;
+    return used;
+}
 
-        value->type = JSON_STRING;
-        value->as.boolean = strncmp(value_, "true", lexer->cursor - start) == 0;
+// Resolved on every use instead of pointing `arena` at own_arena, because
+// lexers are passed around by value.
+AliArena* json_lexer_arena(JsonLexer* lexer) {
+    return lexer->arena != NULL ? lexer->arena : &lexer->own_arena;
+}
 
-        json_arena_rewind(stamp);
-        return true;
-    }
+#define JSON_SCAN_BLOCK 64
 
-    if (*lexer->cursor == '{') {
-        value->type = JSON_OBJECT;
-        value->as.object.len = 0;
-        value->as.object.next = NULL;
+// Bit i of a block mask describes byte i of the 64 byte block at `p`.
+// json_block_eq finds any of four bytes. json_block_string finds the bytes
+// that end a run of plain string contents: '"', '\\', and the bytes below
+// 0x20 as signed chars, which are the control chars and every byte above
+// 0x7f.
+#if defined(JSON_SIMD_AVX2)
+uint64_t json_block_eq(const char* p, char a, char b, char c, char d) {
+    __m256i lo = _mm256_loadu_si256((const __m256i*)p);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(p + 32));
+    __m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b);
+    __m256i vc = _mm256_set1_epi8(c), vd = _mm256_set1_epi8(d);
+    __m256i mlo = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(lo, va), _mm256_cmpeq_epi8(lo, vb)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(lo, vc), _mm256_cmpeq_epi8(lo, vd)));
+    __m256i mhi = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(hi, va), _mm256_cmpeq_epi8(hi, vb)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(hi, vc), _mm256_cmpeq_epi8(hi, vd)));
+    return (uint64_t)(uint32_t)_mm256_movemask_epi8(mlo) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(mhi) << 32);
+}
 
-        json_lexer_expect_char(lexer, '{');
-        while (!json_is_empty(lexer)) {
-            JsonObjectItem item;
-            if (!json_lexer_parse_object_item(lexer, &item)) return false;
-            json_object_append(&value->as.object, item.key, item.value);
-            if (*lexer->cursor != ',') break;
-            if (!json_lexer_expect_char(lexer, ',')) return false;
-        }
-        json_lexer_trim_left(lexer);
-        if (!json_lexer_expect_char(lexer, '}')) return false;
-        return true;
+uint64_t json_block_string(const char* p) {
+    __m256i quote = _mm256_set1_epi8('"'), backslash = _mm256_set1_epi8('\\');
+    __m256i control = _mm256_set1_epi8(0x20);
+    uint64_t mask = 0;
+    for (int i = 0; i < 2; ++i) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i*32));
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+            _mm256_cmpgt_epi8(control, v));
+        mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(m) << (i*32);
     }
-
-    if (*lexer->cursor == '[') {
-        value->type = JSON_ARRAY;
-        value->as.array.len = 0;
-        value->as.array.next = NULL;
-
-        if (!json_lexer_expect_char(lexer, '[')) return false;
-        while (!json_is_empty(lexer)) {
-            JsonValue value_;
-            if (!json_lexer_parse_value(lexer, &value_)) return false;
-            json_array_append(&value->as.array, value_);
-            if (*lexer->cursor != ',') break;
-            if (!json_lexer_expect_char(lexer, ',')) return false;
-        }
-        json_lexer_trim_left(lexer);
-        if (!json_lexer_expect_char(lexer, ']')) return false;
-        return true;
+    return mask;
+}
+#elif defined(JSON_SIMD_SSE2)
+uint64_t json_block_eq(const char* p, char a, char b, char c, char d) {
+    __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b);
+    __m128i vc = _mm_set1_epi8(c), vd = _mm_set1_epi8(d);
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i*16));
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, vc), _mm_cmpeq_epi8(v, vd)));
+        mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(m) << (i*16);
     }
-
-    fprintf(stderr, "Unexpected char '%c'\n", *lexer->cursor);
-    return false;
+    return mask;
 }
 
-bool json_lexer_parse_object_item(JsonLexer* lexer, JsonObjectItem* item) {
-    json_lexer_trim_left(lexer);
-    if (!json_lexer_expect_char(lexer, '"')) return false;
-    const char* start = lexer->cursor;
-    while (!json_is_empty(lexer) && *lexer->cursor != '"') {
-        lexer->cursor++;
+uint64_t json_block_string(const char* p) {
+    __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\');
+    __m128i control = _mm_set1_epi8(0x20);
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i*16));
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+            _mm_cmplt_epi8(v, control));
+        mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(m) << (i*16);
     }
-    item->key = json_strndup(start, (int)(lexer->cursor - start));
-    if (!json_lexer_expect_char(lexer, '"')) return false;
-    if (!json_lexer_expect_char(lexer, ':')) return false;
-    if (!json_lexer_parse_value(lexer, &item->value)) return false;
-    return true;
+    return mask;
+}
+#elif defined(JSON_SIMD_NEON)
+uint64_t json_block_eq(const char* p, char a, char b, char c, char d) {
+    static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t w = vld1q_u8(weights);
+    uint8x16_t va = vdupq_n_u8(a), vb = vdupq_n_u8(b);
+    uint8x16_t vc = vdupq_n_u8(c), vd = vdupq_n_u8(d);
+    uint8x16_t m[4];
+    for (int i = 0; i < 4; ++i) {
+        uint8x16_t v = vld1q_u8((const uint8_t*)(p + i*16));
+        uint8x16_t hit = vorrq_u8(
+            vorrq_u8(vceqq_u8(v, va), vceqq_u8(v, vb)),
+            vorrq_u8(vceqq_u8(v, vc), vceqq_u8(v, vd)));
+        m[i] = vandq_u8(hit, w);
+    }
+    // Three pairwise additions fold every 8 weighted bytes into one mask byte
+    uint8x16_t sum = vpaddq_u8(vpaddq_u8(m[0], m[1]), vpaddq_u8(m[2], m[3]));
+    sum = vpaddq_u8(sum, sum);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum), 0);
 }
 
-void json_stringify(JsonValue* value) {
-    switch (value->type) {
-        case JSON_NUMBER:
-            printf("%.2lf", value->as.number);
-            break;
-        case JSON_STRING:
-            printf("\"%s\"", value->as.string);
-            break;
-        case JSON_BOOLEAN:
-            printf("%s", value->as.boolean ? "true" : "false");
-            break;
-        case JSON_ARRAY: {
-            printf("[");
-            JsonArrayNode* item = value->as.array.next;
-            while (item != NULL) {
-                json_stringify(&item->value);
-                item = item->next;
-                if (item != NULL) printf(", ");
-            }
-            printf("]");
-        } break;
-        case JSON_OBJECT: {
-            printf("{");
-            JsonObjectItem* item = value->as.object.next;
-            while (item != NULL) {
-                printf("\"%s\": ", item->key);
-                json_stringify(&item->value);
-                item = item->next;
-                if (item != NULL) printf(", ");
-            }
-            printf("}");
-        }break;
-        default:
-            UNREACHABLE();
+uint64_t json_block_string(const char* p) {
+    static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t w = vld1q_u8(weights);
+    int8x16_t quote = vdupq_n_s8('"'), backslash = vdupq_n_s8('\\');
+    int8x16_t control = vdupq_n_s8(0x20);
+    uint8x16_t m[4];
+    for (int i = 0; i < 4; ++i) {
+        int8x16_t v = vld1q_s8((const int8_t*)(p + i*16));
+        uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_s8(v, quote), vceqq_s8(v, backslash)), vcltq_s8(v, control));
+        m[i] = vandq_u8(hit, w);
     }
+    uint8x16_t sum = vpaddq_u8(vpaddq_u8(m[0], m[1]), vpaddq_u8(m[2], m[3]));
+    sum = vpaddq_u8(sum, sum);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum), 0);
+}
+#else
+uint64_t json_block_eq(const char* p, char a, char b, char c, char d) {
+    uint64_t mask = 0;
+    for (int i = 0; i < JSON_SCAN_BLOCK; ++i) {
+        char x = p[i];
+        mask |= (uint64_t)(x == a || x == b || x == c || x == d) << i;
+    }
+    return mask;
 }
 
-double* json_value_as_number(JsonValue* value) {
-    if (value->type != JSON_NUMBER) return NULL;
-    return &value->as.number;
+uint64_t json_block_string(const char* p) {
+    uint64_t mask = 0;
+    for (int i = 0; i < JSON_SCAN_BLOCK; ++i) {
+        char x = p[i];
+        mask |= (uint64_t)(x == '"' || x == '\\' || (signed char)x < 0x20) << i;
+    }
+    return mask;
 }
+#endif
 
-char** json_value_as_string(JsonValue* value) {
-    if (value->type != JSON_STRING) return NULL;
-    return &value->as.string;
+bool json_is_whitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
 }
 
-bool* json_value_as_boolean(JsonValue* value) {
-    if (value->type != JSON_BOOLEAN) return NULL;
-    return &value->as.boolean;
+// Returns the first non whitespace byte in [p, end) or end.
+const char* json_skip_whitespace(const char* p, const char* end) {
+    // Compact documents have at most one space between tokens
+    if (p < end && !json_is_whitespace(*p)) return p;
+    if (p + 1 < end && !json_is_whitespace(p[1])) return p + 1;
+
+    while (end - p >= JSON_SCAN_BLOCK) {
+        uint64_t mask = ~json_block_eq(p, ' ', '\n', '\r', '\t');
+        if (mask != 0) return p + __builtin_ctzll(mask);
+        p += JSON_SCAN_BLOCK;
+    }
+    while (p < end && json_is_whitespace(*p)) p++;
+    return p;
 }
 
-JsonArray* json_value_as_array(JsonValue* value) {
-    if (value->type != JSON_ARRAY) return NULL;
-    return &value->as.array;
+// Returns the first '"' or '\\' in [p, end) or end.
+const char* json_scan_string(const char* p, const char* end) {
+    while (end - p >= JSON_SCAN_BLOCK) {
+        uint64_t mask = json_block_eq(p, '"', '\\', '"', '\\');
+        if (mask != 0) return p + __builtin_ctzll(mask);
+        p += JSON_SCAN_BLOCK;
+    }
+    while (p < end && *p != '"' && *p != '\\') p++;
+    return p;
 }
 
-JsonObject* json_value_as_object(JsonValue* value) {
-    if (value->type != JSON_OBJECT) return NULL;
-    return &value->as.object;
+// Returns the length of the well-formed UTF-8 sequence at `p`, which is
+// above 0x7f, or 0. Overlong forms, surrogates and code points above
+// U+10FFFF are ruled out by the range of the second byte.
+size_t json_utf8_len(const char* p, const char* end) {
+    unsigned char c = *p;
+    size_t len;
+    unsigned char low = 0x80, high = 0xbf;
+    if (c >= 0xc2 && c <= 0xdf) {
+        len = 2;
+    } else if (c >= 0xe0 && c <= 0xef) {
+        len = 3;
+        if (c == 0xe0) low = 0xa0;
+        if (c == 0xed) high = 0x9f;
+    } else if (c >= 0xf0 && c <= 0xf4) {
+        len = 4;
+        if (c == 0xf0) low = 0x90;
+        if (c == 0xf4) high = 0x8f;
+    } else {
+        return 0;
+    }
+
+    if ((size_t)(end - p) < len) return 0;
+    if ((unsigned char)p[1] < low || (unsigned char)p[1] > high) return 0;
+    for (size_t i = 2; i < len; ++i) {
+        if (((unsigned char)p[i] & 0xc0) != 0x80) return 0;
+    }
+    return len;
 }
 
-JsonValue* json_object_find_value(JsonObject* object, char* key) {
-    if (object->len == 0) return NULL;
+// Returns the first byte in [p, end) that plain string contents can't
+// hold: a '"', a '\\', a control char or a byte that isn't part of a
+// well-formed UTF-8 sequence, or end. The parser and json_validate both
+// scan strings with it.
+const char* json_scan_string_body(const char* p, const char* end) {
+    for (;;) {
+        while (end - p >= JSON_SCAN_BLOCK) {
+            uint64_t mask = json_block_string(p);
+            if (mask != 0) {
+                p += __builtin_ctzll(mask);
+                break;
+            }
+            p += JSON_SCAN_BLOCK;
+        }
+        while (p < end && *p != '"' && *p != '\\' && (signed char)*p >= 0x20) p++;
 
-    JsonObjectItem* item = object->next;
-    while (item != NULL) {
-        if (strcmp(item->key, key) == 0) return &item->value;
-        item = item->next;
+        // Bytes above 0x7f stop the block scan too
+        if (p >= end || (unsigned char)*p < 0x80) return p;
+        size_t len = json_utf8_len(p, end);
+        if (len == 0) return p;
+        p += len;
     }
+}
 
+// Finds the next '\n' at or after `p`, or returns `end`.
+const char* json_scan_newline(const char* p, const char* end) {
+    while (end - p >= JSON_SCAN_BLOCK) {
+        uint64_t mask = json_block_eq(p, '\n', '\n', '\n', '\n');
+        if (mask != 0) return p + __builtin_ctzll(mask);
+        p += JSON_SCAN_BLOCK;
+    }
+    while (p < end && *p != '\n') p++;
+    return p;
+}
+
+// Numbers
+
+typedef struct {
+    double number;
+
+    // Set when the literal has no fraction or exponent and fits into int64
+    bool is_integer;
+    int64_t integer;
+}JsonNumber;
+
+// 128 bit approximations of 5^q for q in [JSON_POW5_MIN, JSON_POW5_MAX],
+// normalized so that the top bit is set (high word first). The powers
+// past 10^308 are for json_grisu2, the smallest subnormal needs 10^324.
+#define JSON_POW5_MIN (-342)
+#define JSON_POW5_MAX 324
+static const uint64_t json_pow5_table[][2] = {
+    { 0xeef453d6923bd65a, 0x113faa2906a13b3f },
+    { 0x9558b4661b6565f8, 0x4ac7ca59a424c507 },
+    { 0xbaaee17fa23ebf76, 0x5d79bcf00d2df649 },
+    { 0xe95a99df8ace6f53, 0xf4d82c2c107973dc },
+    { 0x91d8a02bb6c10594, 0x79071b9b8a4be869 },
+    { 0xb64ec836a47146f9, 0x9748e2826cdee284 },
+    { 0xe3e27a444d8d98b7, 0xfd1b1b2308169b25 },
+    { 0x8e6d8c6ab0787f72, 0xfe30f0f5e50e20f7 },
+    { 0xb208ef855c969f4f, 0xbdbd2d335e51a935 },
+    { 0xde8b2b66b3bc4723, 0xad2c788035e61382 },
+    { 0x8b16fb203055ac76, 0x4c3bcb5021afcc31 },
+    { 0xaddcb9e83c6b1793, 0xdf4abe242a1bbf3d },
+    { 0xd953e8624b85dd78, 0xd71d6dad34a2af0d },
+    { 0x87d4713d6f33aa6b, 0x8672648c40e5ad68 },
+    { 0xa9c98d8ccb009506, 0x680efdaf511f18c2 },
+    { 0xd43bf0effdc0ba48, 0x0212bd1b2566def2 },
+    { 0x84a57695fe98746d, 0x014bb630f7604b57 },
+    { 0xa5ced43b7e3e9188, 0x419ea3bd35385e2d },
+    { 0xcf42894a5dce35ea, 0x52064cac828675b9 },
+    { 0x818995ce7aa0e1b2, 0x7343efebd1940993 },
+    { 0xa1ebfb4219491a1f, 0x1014ebe6c5f90bf8 },
+    { 0xca66fa129f9b60a6, 0xd41a26e077774ef6 },
+    { 0xfd00b897478238d0, 0x8920b098955522b4 },
+    { 0x9e20735e8cb16382, 0x55b46e5f5d5535b0 },
+    { 0xc5a890362fddbc62, 0xeb2189f734aa831d },
+    { 0xf712b443bbd52b7b, 0xa5e9ec7501d523e4 },
+    { 0x9a6bb0aa55653b2d, 0x47b233c92125366e },
+    { 0xc1069cd4eabe89f8, 0x999ec0bb696e840a },
+    { 0xf148440a256e2c76, 0xc00670ea43ca250d },
+    { 0x96cd2a865764dbca, 0x380406926a5e5728 },
+    { 0xbc807527ed3e12bc, 0xc605083704f5ecf2 },
+    { 0xeba09271e88d976b, 0xf7864a44c633682e },
+    { 0x93445b8731587ea3, 0x7ab3ee6afbe0211d },
+    { 0xb8157268fdae9e4c, 0x5960ea05bad82964 },
+    { 0xe61acf033d1a45df, 0x6fb92487298e33bd },
+    { 0x8fd0c16206306bab, 0xa5d3b6d479f8e056 },
+    { 0xb3c4f1ba87bc8696, 0x8f48a4899877186c },
+    { 0xe0b62e2929aba83c, 0x331acdabfe94de87 },
+    { 0x8c71dcd9ba0b4925, 0x9ff0c08b7f1d0b14 },
+    { 0xaf8e5410288e1b6f, 0x07ecf0ae5ee44dd9 },
+    { 0xdb71e91432b1a24a, 0xc9e82cd9f69d6150 },
+    { 0x892731ac9faf056e, 0xbe311c083a225cd2 },
+    { 0xab70fe17c79ac6ca, 0x6dbd630a48aaf406 },
+    { 0xd64d3d9db981787d, 0x092cbbccdad5b108 },
+    { 0x85f0468293f0eb4e, 0x25bbf56008c58ea5 },
+    { 0xa76c582338ed2621, 0xaf2af2b80af6f24e },
+    { 0xd1476e2c07286faa, 0x1af5af660db4aee1 },
+    { 0x82cca4db847945ca, 0x50d98d9fc890ed4d },
+    { 0xa37fce126597973c, 0xe50ff107bab528a0 },
+    { 0xcc5fc196fefd7d0c, 0x1e53ed49a96272c8 },
+    { 0xff77b1fcbebcdc4f, 0x25e8e89c13bb0f7a },
+    { 0x9faacf3df73609b1, 0x77b191618c54e9ac },
+    { 0xc795830d75038c1d, 0xd59df5b9ef6a2417 },
+    { 0xf97ae3d0d2446f25, 0x4b0573286b44ad1d },
+    { 0x9becce62836ac577, 0x4ee367f9430aec32 },
+    { 0xc2e801fb244576d5, 0x229c41f793cda73f },
+    { 0xf3a20279ed56d48a, 0x6b43527578c1110f },
+    { 0x9845418c345644d6, 0x830a13896b78aaa9 },
+    { 0xbe5691ef416bd60c, 0x23cc986bc656d553 },
+    { 0xedec366b11c6cb8f, 0x2cbfbe86b7ec8aa8 },
+    { 0x94b3a202eb1c3f39, 0x7bf7d71432f3d6a9 },
+    { 0xb9e08a83a5e34f07, 0xdaf5ccd93fb0cc53 },
+    { 0xe858ad248f5c22c9, 0xd1b3400f8f9cff68 },
+    { 0x91376c36d99995be, 0x23100809b9c21fa1 },
+    { 0xb58547448ffffb2d, 0xabd40a0c2832a78a },
+    { 0xe2e69915b3fff9f9, 0x16c90c8f323f516c },
+    { 0x8dd01fad907ffc3b, 0xae3da7d97f6792e3 },
+    { 0xb1442798f49ffb4a, 0x99cd11cfdf41779c },
+    { 0xdd95317f31c7fa1d, 0x40405643d711d583 },
+    { 0x8a7d3eef7f1cfc52, 0x482835ea666b2572 },
+    { 0xad1c8eab5ee43b66, 0xda3243650005eecf },
+    { 0xd863b256369d4a40, 0x90bed43e40076a82 },
+    { 0x873e4f75e2224e68, 0x5a7744a6e804a291 },
+    { 0xa90de3535aaae202, 0x711515d0a205cb36 },
+    { 0xd3515c2831559a83, 0x0d5a5b44ca873e03 },
+    { 0x8412d9991ed58091, 0xe858790afe9486c2 },
+    { 0xa5178fff668ae0b6, 0x626e974dbe39a872 },
+    { 0xce5d73ff402d98e3, 0xfb0a3d212dc8128f },
+    { 0x80fa687f881c7f8e, 0x7ce66634bc9d0b99 },
+    { 0xa139029f6a239f72, 0x1c1fffc1ebc44e80 },
+    { 0xc987434744ac874e, 0xa327ffb266b56220 },
+    { 0xfbe9141915d7a922, 0x4bf1ff9f0062baa8 },
+    { 0x9d71ac8fada6c9b5, 0x6f773fc3603db4a9 },
+    { 0xc4ce17b399107c22, 0xcb550fb4384d21d3 },
+    { 0xf6019da07f549b2b, 0x7e2a53a146606a48 },
+    { 0x99c102844f94e0fb, 0x2eda7444cbfc426d },
+    { 0xc0314325637a1939, 0xfa911155fefb5308 },
+    { 0xf03d93eebc589f88, 0x793555ab7eba27ca },
+    { 0x96267c7535b763b5, 0x4bc1558b2f3458de },
+    { 0xbbb01b9283253ca2, 0x9eb1aaedfb016f16 },
+    { 0xea9c227723ee8bcb, 0x465e15a979c1cadc },
+    { 0x92a1958a7675175f, 0x0bfacd89ec191ec9 },
+    { 0xb749faed14125d36, 0xcef980ec671f667b },
+    { 0xe51c79a85916f484, 0x82b7e12780e7401a },
+    { 0x8f31cc0937ae58d2, 0xd1b2ecb8b0908810 },
+    { 0xb2fe3f0b8599ef07, 0x861fa7e6dcb4aa15 },
+    { 0xdfbdcece67006ac9, 0x67a791e093e1d49a },
+    { 0x8bd6a141006042bd, 0xe0c8bb2c5c6d24e0 },
+    { 0xaecc49914078536d, 0x58fae9f773886e18 },
+    { 0xda7f5bf590966848, 0xaf39a475506a899e },
+    { 0x888f99797a5e012d, 0x6d8406c952429603 },
+    { 0xaab37fd7d8f58178, 0xc8e5087ba6d33b83 },
+    { 0xd5605fcdcf32e1d6, 0xfb1e4a9a90880a64 },
+    { 0x855c3be0a17fcd26, 0x5cf2eea09a55067f },
+    { 0xa6b34ad8c9dfc06f, 0xf42faa48c0ea481e },
+    { 0xd0601d8efc57b08b, 0xf13b94daf124da26 },
+    { 0x823c12795db6ce57, 0x76c53d08d6b70858 },
+    { 0xa2cb1717b52481ed, 0x54768c4b0c64ca6e },
+    { 0xcb7ddcdda26da268, 0xa9942f5dcf7dfd09 },
+    { 0xfe5d54150b090b02, 0xd3f93b35435d7c4c },
+    { 0x9efa548d26e5a6e1, 0xc47bc5014a1a6daf },
+    { 0xc6b8e9b0709f109a, 0x359ab6419ca1091b },
+    { 0xf867241c8cc6d4c0, 0xc30163d203c94b62 },
+    { 0x9b407691d7fc44f8, 0x79e0de63425dcf1d },
+    { 0xc21094364dfb5636, 0x985915fc12f542e4 },
+    { 0xf294b943e17a2bc4, 0x3e6f5b7b17b2939d },
+    { 0x979cf3ca6cec5b5a, 0xa705992ceecf9c42 },
+    { 0xbd8430bd08277231, 0x50c6ff782a838353 },
+    { 0xece53cec4a314ebd, 0xa4f8bf5635246428 },
+    { 0x940f4613ae5ed136, 0x871b7795e136be99 },
+    { 0xb913179899f68584, 0x28e2557b59846e3f },
+    { 0xe757dd7ec07426e5, 0x331aeada2fe589cf },
+    { 0x9096ea6f3848984f, 0x3ff0d2c85def7621 },
+    { 0xb4bca50b065abe63, 0x0fed077a756b53a9 },
+    { 0xe1ebce4dc7f16dfb, 0xd3e8495912c62894 },
+    { 0x8d3360f09cf6e4bd, 0x64712dd7abbbd95c },
+    { 0xb080392cc4349dec, 0xbd8d794d96aacfb3 },
+    { 0xdca04777f541c567, 0xecf0d7a0fc5583a0 },
+    { 0x89e42caaf9491b60, 0xf41686c49db57244 },
+    { 0xac5d37d5b79b6239, 0x311c2875c522ced5 },
+    { 0xd77485cb25823ac7, 0x7d633293366b828b },
+    { 0x86a8d39ef77164bc, 0xae5dff9c02033197 },
+    { 0xa8530886b54dbdeb, 0xd9f57f830283fdfc },
+    { 0xd267caa862a12d66, 0xd072df63c324fd7b },
+    { 0x8380dea93da4bc60, 0x4247cb9e59f71e6d },
+    { 0xa46116538d0deb78, 0x52d9be85f074e608 },
+    { 0xcd795be870516656, 0x67902e276c921f8b },
+    { 0x806bd9714632dff6, 0x00ba1cd8a3db53b6 },
+    { 0xa086cfcd97bf97f3, 0x80e8a40eccd228a4 },
+    { 0xc8a883c0fdaf7df0, 0x6122cd128006b2cd },
+    { 0xfad2a4b13d1b5d6c, 0x796b805720085f81 },
+    { 0x9cc3a6eec6311a63, 0xcbe3303674053bb0 },
+    { 0xc3f490aa77bd60fc, 0xbedbfc4411068a9c },
+    { 0xf4f1b4d515acb93b, 0xee92fb5515482d44 },
+    { 0x991711052d8bf3c5, 0x751bdd152d4d1c4a },
+    { 0xbf5cd54678eef0b6, 0xd262d45a78a0635d },
+    { 0xef340a98172aace4, 0x86fb897116c87c34 },
+    { 0x9580869f0e7aac0e, 0xd45d35e6ae3d4da0 },
+    { 0xbae0a846d2195712, 0x8974836059cca109 },
+    { 0xe998d258869facd7, 0x2bd1a438703fc94b },
+    { 0x91ff83775423cc06, 0x7b6306a34627ddcf },
+    { 0xb67f6455292cbf08, 0x1a3bc84c17b1d542 },
+    { 0xe41f3d6a7377eeca, 0x20caba5f1d9e4a93 },
+    { 0x8e938662882af53e, 0x547eb47b7282ee9c },
+    { 0xb23867fb2a35b28d, 0xe99e619a4f23aa43 },
+    { 0xdec681f9f4c31f31, 0x6405fa00e2ec94d4 },
+    { 0x8b3c113c38f9f37e, 0xde83bc408dd3dd04 },
+    { 0xae0b158b4738705e, 0x9624ab50b148d445 },
+    { 0xd98ddaee19068c76, 0x3badd624dd9b0957 },
+    { 0x87f8a8d4cfa417c9, 0xe54ca5d70a80e5d6 },
+    { 0xa9f6d30a038d1dbc, 0x5e9fcf4ccd211f4c },
+    { 0xd47487cc8470652b, 0x7647c3200069671f },
+    { 0x84c8d4dfd2c63f3b, 0x29ecd9f40041e073 },
+    { 0xa5fb0a17c777cf09, 0xf468107100525890 },
+    { 0xcf79cc9db955c2cc, 0x7182148d4066eeb4 },
+    { 0x81ac1fe293d599bf, 0xc6f14cd848405530 },
+    { 0xa21727db38cb002f, 0xb8ada00e5a506a7c },
+    { 0xca9cf1d206fdc03b, 0xa6d90811f0e4851c },
+    { 0xfd442e4688bd304a, 0x908f4a166d1da663 },
+    { 0x9e4a9cec15763e2e, 0x9a598e4e043287fe },
+    { 0xc5dd44271ad3cdba, 0x40eff1e1853f29fd },
+    { 0xf7549530e188c128, 0xd12bee59e68ef47c },
+    { 0x9a94dd3e8cf578b9, 0x82bb74f8301958ce },
+    { 0xc13a148e3032d6e7, 0xe36a52363c1faf01 },
+    { 0xf18899b1bc3f8ca1, 0xdc44e6c3cb279ac1 },
+    { 0x96f5600f15a7b7e5, 0x29ab103a5ef8c0b9 },
+    { 0xbcb2b812db11a5de, 0x7415d448f6b6f0e7 },
+    { 0xebdf661791d60f56, 0x111b495b3464ad21 },
+    { 0x936b9fcebb25c995, 0xcab10dd900beec34 },
+    { 0xb84687c269ef3bfb, 0x3d5d514f40eea742 },
+    { 0xe65829b3046b0afa, 0x0cb4a5a3112a5112 },
+    { 0x8ff71a0fe2c2e6dc, 0x47f0e785eaba72ab },
+    { 0xb3f4e093db73a093, 0x59ed216765690f56 },
+    { 0xe0f218b8d25088b8, 0x306869c13ec3532c },
+    { 0x8c974f7383725573, 0x1e414218c73a13fb },
+    { 0xafbd2350644eeacf, 0xe5d1929ef90898fa },
+    { 0xdbac6c247d62a583, 0xdf45f746b74abf39 },
+    { 0x894bc396ce5da772, 0x6b8bba8c328eb783 },
+    { 0xab9eb47c81f5114f, 0x066ea92f3f326564 },
+    { 0xd686619ba27255a2, 0xc80a537b0efefebd },
+    { 0x8613fd0145877585, 0xbd06742ce95f5f36 },
+    { 0xa798fc4196e952e7, 0x2c48113823b73704 },
+    { 0xd17f3b51fca3a7a0, 0xf75a15862ca504c5 },
+    { 0x82ef85133de648c4, 0x9a984d73dbe722fb },
+    { 0xa3ab66580d5fdaf5, 0xc13e60d0d2e0ebba },
+    { 0xcc963fee10b7d1b3, 0x318df905079926a8 },
+    { 0xffbbcfe994e5c61f, 0xfdf17746497f7052 },
+    { 0x9fd561f1fd0f9bd3, 0xfeb6ea8bedefa633 },
+    { 0xc7caba6e7c5382c8, 0xfe64a52ee96b8fc0 },
+    { 0xf9bd690a1b68637b, 0x3dfdce7aa3c673b0 },
+    { 0x9c1661a651213e2d, 0x06bea10ca65c084e },
+    { 0xc31bfa0fe5698db8, 0x486e494fcff30a62 },
+    { 0xf3e2f893dec3f126, 0x5a89dba3c3efccfa },
+    { 0x986ddb5c6b3a76b7, 0xf89629465a75e01c },
+    { 0xbe89523386091465, 0xf6bbb397f1135823 },
+    { 0xee2ba6c0678b597f, 0x746aa07ded582e2c },
+    { 0x94db483840b717ef, 0xa8c2a44eb4571cdc },
+    { 0xba121a4650e4ddeb, 0x92f34d62616ce413 },
+    { 0xe896a0d7e51e1566, 0x77b020baf9c81d17 },
+    { 0x915e2486ef32cd60, 0x0ace1474dc1d122e },
+    { 0xb5b5ada8aaff80b8, 0x0d819992132456ba },
+    { 0xe3231912d5bf60e6, 0x10e1fff697ed6c69 },
+    { 0x8df5efabc5979c8f, 0xca8d3ffa1ef463c1 },
+    { 0xb1736b96b6fd83b3, 0xbd308ff8a6b17cb2 },
+    { 0xddd0467c64bce4a0, 0xac7cb3f6d05ddbde },
+    { 0x8aa22c0dbef60ee4, 0x6bcdf07a423aa96b },
+    { 0xad4ab7112eb3929d, 0x86c16c98d2c953c6 },
+    { 0xd89d64d57a607744, 0xe871c7bf077ba8b7 },
+    { 0x87625f056c7c4a8b, 0x11471cd764ad4972 },
+    { 0xa93af6c6c79b5d2d, 0xd598e40d3dd89bcf },
+    { 0xd389b47879823479, 0x4aff1d108d4ec2c3 },
+    { 0x843610cb4bf160cb, 0xcedf722a585139ba },
+    { 0xa54394fe1eedb8fe, 0xc2974eb4ee658828 },
+    { 0xce947a3da6a9273e, 0x733d226229feea32 },
+    { 0x811ccc668829b887, 0x0806357d5a3f525f },
+    { 0xa163ff802a3426a8, 0xca07c2dcb0cf26f7 },
+    { 0xc9bcff6034c13052, 0xfc89b393dd02f0b5 },
+    { 0xfc2c3f3841f17c67, 0xbbac2078d443ace2 },
+    { 0x9d9ba7832936edc0, 0xd54b944b84aa4c0d },
+    { 0xc5029163f384a931, 0x0a9e795e65d4df11 },
+    { 0xf64335bcf065d37d, 0x4d4617b5ff4a16d5 },
+    { 0x99ea0196163fa42e, 0x504bced1bf8e4e45 },
+    { 0xc06481fb9bcf8d39, 0xe45ec2862f71e1d6 },
+    { 0xf07da27a82c37088, 0x5d767327bb4e5a4c },
+    { 0x964e858c91ba2655, 0x3a6a07f8d510f86f },
+    { 0xbbe226efb628afea, 0x890489f70a55368b },
+    { 0xeadab0aba3b2dbe5, 0x2b45ac74ccea842e },
+    { 0x92c8ae6b464fc96f, 0x3b0b8bc90012929d },
+    { 0xb77ada0617e3bbcb, 0x09ce6ebb40173744 },
+    { 0xe55990879ddcaabd, 0xcc420a6a101d0515 },
+    { 0x8f57fa54c2a9eab6, 0x9fa946824a12232d },
+    { 0xb32df8e9f3546564, 0x47939822dc96abf9 },
+    { 0xdff9772470297ebd, 0x59787e2b93bc56f7 },
+    { 0x8bfbea76c619ef36, 0x57eb4edb3c55b65a },
+    { 0xaefae51477a06b03, 0xede622920b6b23f1 },
+    { 0xdab99e59958885c4, 0xe95fab368e45eced },
+    { 0x88b402f7fd75539b, 0x11dbcb0218ebb414 },
+    { 0xaae103b5fcd2a881, 0xd652bdc29f26a119 },
+    { 0xd59944a37c0752a2, 0x4be76d3346f0495f },
+    { 0x857fcae62d8493a5, 0x6f70a4400c562ddb },
+    { 0xa6dfbd9fb8e5b88e, 0xcb4ccd500f6bb952 },
+    { 0xd097ad07a71f26b2, 0x7e2000a41346a7a7 },
+    { 0x825ecc24c873782f, 0x8ed400668c0c28c8 },
+    { 0xa2f67f2dfa90563b, 0x728900802f0f32fa },
+    { 0xcbb41ef979346bca, 0x4f2b40a03ad2ffb9 },
+    { 0xfea126b7d78186bc, 0xe2f610c84987bfa8 },
+    { 0x9f24b832e6b0f436, 0x0dd9ca7d2df4d7c9 },
+    { 0xc6ede63fa05d3143, 0x91503d1c79720dbb },
+    { 0xf8a95fcf88747d94, 0x75a44c6397ce912a },
+    { 0x9b69dbe1b548ce7c, 0xc986afbe3ee11aba },
+    { 0xc24452da229b021b, 0xfbe85badce996168 },
+    { 0xf2d56790ab41c2a2, 0xfae27299423fb9c3 },
+    { 0x97c560ba6b0919a5, 0xdccd879fc967d41a },
+    { 0xbdb6b8e905cb600f, 0x5400e987bbc1c920 },
+    { 0xed246723473e3813, 0x290123e9aab23b68 },
+    { 0x9436c0760c86e30b, 0xf9a0b6720aaf6521 },
+    { 0xb94470938fa89bce, 0xf808e40e8d5b3e69 },
+    { 0xe7958cb87392c2c2, 0xb60b1d1230b20e04 },
+    { 0x90bd77f3483bb9b9, 0xb1c6f22b5e6f48c2 },
+    { 0xb4ecd5f01a4aa828, 0x1e38aeb6360b1af3 },
+    { 0xe2280b6c20dd5232, 0x25c6da63c38de1b0 },
+    { 0x8d590723948a535f, 0x579c487e5a38ad0e },
+    { 0xb0af48ec79ace837, 0x2d835a9df0c6d851 },
+    { 0xdcdb1b2798182244, 0xf8e431456cf88e65 },
+    { 0x8a08f0f8bf0f156b, 0x1b8e9ecb641b58ff },
+    { 0xac8b2d36eed2dac5, 0xe272467e3d222f3f },
+    { 0xd7adf884aa879177, 0x5b0ed81dcc6abb0f },
+    { 0x86ccbb52ea94baea, 0x98e947129fc2b4e9 },
+    { 0xa87fea27a539e9a5, 0x3f2398d747b36224 },
+    { 0xd29fe4b18e88640e, 0x8eec7f0d19a03aad },
+    { 0x83a3eeeef9153e89, 0x1953cf68300424ac },
+    { 0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd7 },
+    { 0xcdb02555653131b6, 0x3792f412cb06794d },
+    { 0x808e17555f3ebf11, 0xe2bbd88bbee40bd0 },
+    { 0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec4 },
+    { 0xc8de047564d20a8b, 0xf245825a5a445275 },
+    { 0xfb158592be068d2e, 0xeed6e2f0f0d56712 },
+    { 0x9ced737bb6c4183d, 0x55464dd69685606b },
+    { 0xc428d05aa4751e4c, 0xaa97e14c3c26b886 },
+    { 0xf53304714d9265df, 0xd53dd99f4b3066a8 },
+    { 0x993fe2c6d07b7fab, 0xe546a8038efe4029 },
+    { 0xbf8fdb78849a5f96, 0xde98520472bdd033 },
+    { 0xef73d256a5c0f77c, 0x963e66858f6d4440 },
+    { 0x95a8637627989aad, 0xdde7001379a44aa8 },
+    { 0xbb127c53b17ec159, 0x5560c018580d5d52 },
+    { 0xe9d71b689dde71af, 0xaab8f01e6e10b4a6 },
+    { 0x9226712162ab070d, 0xcab3961304ca70e8 },
+    { 0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d22 },
+    { 0xe45c10c42a2b3b05, 0x8cb89a7db77c506a },
+    { 0x8eb98a7a9a5b04e3, 0x77f3608e92adb242 },
+    { 0xb267ed1940f1c61c, 0x55f038b237591ed3 },
+    { 0xdf01e85f912e37a3, 0x6b6c46dec52f6688 },
+    { 0x8b61313bbabce2c6, 0x2323ac4b3b3da015 },
+    { 0xae397d8aa96c1b77, 0xabec975e0a0d081a },
+    { 0xd9c7dced53c72255, 0x96e7bd358c904a21 },
+    { 0x881cea14545c7575, 0x7e50d64177da2e54 },
+    { 0xaa242499697392d2, 0xdde50bd1d5d0b9e9 },
+    { 0xd4ad2dbfc3d07787, 0x955e4ec64b44e864 },
+    { 0x84ec3c97da624ab4, 0xbd5af13bef0b113e },
+    { 0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58e },
+    { 0xcfb11ead453994ba, 0x67de18eda5814af2 },
+    { 0x81ceb32c4b43fcf4, 0x80eacf948770ced7 },
+    { 0xa2425ff75e14fc31, 0xa1258379a94d028d },
+    { 0xcad2f7f5359a3b3e, 0x096ee45813a04330 },
+    { 0xfd87b5f28300ca0d, 0x8bca9d6e188853fc },
+    { 0x9e74d1b791e07e48, 0x775ea264cf55347e },
+    { 0xc612062576589dda, 0x95364afe032a819e },
+    { 0xf79687aed3eec551, 0x3a83ddbd83f52205 },
+    { 0x9abe14cd44753b52, 0xc4926a9672793543 },
+    { 0xc16d9a0095928a27, 0x75b7053c0f178294 },
+    { 0xf1c90080baf72cb1, 0x5324c68b12dd6339 },
+    { 0x971da05074da7bee, 0xd3f6fc16ebca5e04 },
+    { 0xbce5086492111aea, 0x88f4bb1ca6bcf585 },
+    { 0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6 },
+    { 0x9392ee8e921d5d07, 0x3aff322e62439fd0 },
+    { 0xb877aa3236a4b449, 0x09befeb9fad487c3 },
+    { 0xe69594bec44de15b, 0x4c2ebe687989a9b4 },
+    { 0x901d7cf73ab0acd9, 0x0f9d37014bf60a11 },
+    { 0xb424dc35095cd80f, 0x538484c19ef38c95 },
+    { 0xe12e13424bb40e13, 0x2865a5f206b06fba },
+    { 0x8cbccc096f5088cb, 0xf93f87b7442e45d4 },
+    { 0xafebff0bcb24aafe, 0xf78f69a51539d749 },
+    { 0xdbe6fecebdedd5be, 0xb573440e5a884d1c },
+    { 0x89705f4136b4a597, 0x31680a88f8953031 },
+    { 0xabcc77118461cefc, 0xfdc20d2b36ba7c3e },
+    { 0xd6bf94d5e57a42bc, 0x3d32907604691b4d },
+    { 0x8637bd05af6c69b5, 0xa63f9a49c2c1b110 },
+    { 0xa7c5ac471b478423, 0x0fcf80dc33721d54 },
+    { 0xd1b71758e219652b, 0xd3c36113404ea4a9 },
+    { 0x83126e978d4fdf3b, 0x645a1cac083126ea },
+    { 0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4 },
+    { 0xcccccccccccccccc, 0xcccccccccccccccd },
+    { 0x8000000000000000, 0x0000000000000000 },
+    { 0xa000000000000000, 0x0000000000000000 },
+    { 0xc800000000000000, 0x0000000000000000 },
+    { 0xfa00000000000000, 0x0000000000000000 },
+    { 0x9c40000000000000, 0x0000000000000000 },
+    { 0xc350000000000000, 0x0000000000000000 },
+    { 0xf424000000000000, 0x0000000000000000 },
+    { 0x9896800000000000, 0x0000000000000000 },
+    { 0xbebc200000000000, 0x0000000000000000 },
+    { 0xee6b280000000000, 0x0000000000000000 },
+    { 0x9502f90000000000, 0x0000000000000000 },
+    { 0xba43b74000000000, 0x0000000000000000 },
+    { 0xe8d4a51000000000, 0x0000000000000000 },
+    { 0x9184e72a00000000, 0x0000000000000000 },
+    { 0xb5e620f480000000, 0x0000000000000000 },
+    { 0xe35fa931a0000000, 0x0000000000000000 },
+    { 0x8e1bc9bf04000000, 0x0000000000000000 },
+    { 0xb1a2bc2ec5000000, 0x0000000000000000 },
+    { 0xde0b6b3a76400000, 0x0000000000000000 },
+    { 0x8ac7230489e80000, 0x0000000000000000 },
+    { 0xad78ebc5ac620000, 0x0000000000000000 },
+    { 0xd8d726b7177a8000, 0x0000000000000000 },
+    { 0x878678326eac9000, 0x0000000000000000 },
+    { 0xa968163f0a57b400, 0x0000000000000000 },
+    { 0xd3c21bcecceda100, 0x0000000000000000 },
+    { 0x84595161401484a0, 0x0000000000000000 },
+    { 0xa56fa5b99019a5c8, 0x0000000000000000 },
+    { 0xcecb8f27f4200f3a, 0x0000000000000000 },
+    { 0x813f3978f8940984, 0x4000000000000000 },
+    { 0xa18f07d736b90be5, 0x5000000000000000 },
+    { 0xc9f2c9cd04674ede, 0xa400000000000000 },
+    { 0xfc6f7c4045812296, 0x4d00000000000000 },
+    { 0x9dc5ada82b70b59d, 0xf020000000000000 },
+    { 0xc5371912364ce305, 0x6c28000000000000 },
+    { 0xf684df56c3e01bc6, 0xc732000000000000 },
+    { 0x9a130b963a6c115c, 0x3c7f400000000000 },
+    { 0xc097ce7bc90715b3, 0x4b9f100000000000 },
+    { 0xf0bdc21abb48db20, 0x1e86d40000000000 },
+    { 0x96769950b50d88f4, 0x1314448000000000 },
+    { 0xbc143fa4e250eb31, 0x17d955a000000000 },
+    { 0xeb194f8e1ae525fd, 0x5dcfab0800000000 },
+    { 0x92efd1b8d0cf37be, 0x5aa1cae500000000 },
+    { 0xb7abc627050305ad, 0xf14a3d9e40000000 },
+    { 0xe596b7b0c643c719, 0x6d9ccd05d0000000 },
+    { 0x8f7e32ce7bea5c6f, 0xe4820023a2000000 },
+    { 0xb35dbf821ae4f38b, 0xdda2802c8a800000 },
+    { 0xe0352f62a19e306e, 0xd50b2037ad200000 },
+    { 0x8c213d9da502de45, 0x4526f422cc340000 },
+    { 0xaf298d050e4395d6, 0x9670b12b7f410000 },
+    { 0xdaf3f04651d47b4c, 0x3c0cdd765f114000 },
+    { 0x88d8762bf324cd0f, 0xa5880a69fb6ac800 },
+    { 0xab0e93b6efee0053, 0x8eea0d047a457a00 },
+    { 0xd5d238a4abe98068, 0x72a4904598d6d880 },
+    { 0x85a36366eb71f041, 0x47a6da2b7f864750 },
+    { 0xa70c3c40a64e6c51, 0x999090b65f67d924 },
+    { 0xd0cf4b50cfe20765, 0xfff4b4e3f741cf6d },
+    { 0x82818f1281ed449f, 0xbff8f10e7a8921a4 },
+    { 0xa321f2d7226895c7, 0xaff72d52192b6a0d },
+    { 0xcbea6f8ceb02bb39, 0x9bf4f8a69f764490 },
+    { 0xfee50b7025c36a08, 0x02f236d04753d5b4 },
+    { 0x9f4f2726179a2245, 0x01d762422c946590 },
+    { 0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef5 },
+    { 0xf8ebad2b84e0d58b, 0xd2e0898765a7deb2 },
+    { 0x9b934c3b330c8577, 0x63cc55f49f88eb2f },
+    { 0xc2781f49ffcfa6d5, 0x3cbf6b71c76b25fb },
+    { 0xf316271c7fc3908a, 0x8bef464e3945ef7a },
+    { 0x97edd871cfda3a56, 0x97758bf0e3cbb5ac },
+    { 0xbde94e8e43d0c8ec, 0x3d52eeed1cbea317 },
+    { 0xed63a231d4c4fb27, 0x4ca7aaa863ee4bdd },
+    { 0x945e455f24fb1cf8, 0x8fe8caa93e74ef6a },
+    { 0xb975d6b6ee39e436, 0xb3e2fd538e122b44 },
+    { 0xe7d34c64a9c85d44, 0x60dbbca87196b616 },
+    { 0x90e40fbeea1d3a4a, 0xbc8955e946fe31cd },
+    { 0xb51d13aea4a488dd, 0x6babab6398bdbe41 },
+    { 0xe264589a4dcdab14, 0xc696963c7eed2dd1 },
+    { 0x8d7eb76070a08aec, 0xfc1e1de5cf543ca2 },
+    { 0xb0de65388cc8ada8, 0x3b25a55f43294bcb },
+    { 0xdd15fe86affad912, 0x49ef0eb713f39ebe },
+    { 0x8a2dbf142dfcc7ab, 0x6e3569326c784337 },
+    { 0xacb92ed9397bf996, 0x49c2c37f07965404 },
+    { 0xd7e77a8f87daf7fb, 0xdc33745ec97be906 },
+    { 0x86f0ac99b4e8dafd, 0x69a028bb3ded71a3 },
+    { 0xa8acd7c0222311bc, 0xc40832ea0d68ce0c },
+    { 0xd2d80db02aabd62b, 0xf50a3fa490c30190 },
+    { 0x83c7088e1aab65db, 0x792667c6da79e0fa },
+    { 0xa4b8cab1a1563f52, 0x577001b891185938 },
+    { 0xcde6fd5e09abcf26, 0xed4c0226b55e6f86 },
+    { 0x80b05e5ac60b6178, 0x544f8158315b05b4 },
+    { 0xa0dc75f1778e39d6, 0x696361ae3db1c721 },
+    { 0xc913936dd571c84c, 0x03bc3a19cd1e38e9 },
+    { 0xfb5878494ace3a5f, 0x04ab48a04065c723 },
+    { 0x9d174b2dcec0e47b, 0x62eb0d64283f9c76 },
+    { 0xc45d1df942711d9a, 0x3ba5d0bd324f8394 },
+    { 0xf5746577930d6500, 0xca8f44ec7ee36479 },
+    { 0x9968bf6abbe85f20, 0x7e998b13cf4e1ecb },
+    { 0xbfc2ef456ae276e8, 0x9e3fedd8c321a67e },
+    { 0xefb3ab16c59b14a2, 0xc5cfe94ef3ea101e },
+    { 0x95d04aee3b80ece5, 0xbba1f1d158724a12 },
+    { 0xbb445da9ca61281f, 0x2a8a6e45ae8edc97 },
+    { 0xea1575143cf97226, 0xf52d09d71a3293bd },
+    { 0x924d692ca61be758, 0x593c2626705f9c56 },
+    { 0xb6e0c377cfa2e12e, 0x6f8b2fb00c77836c },
+    { 0xe498f455c38b997a, 0x0b6dfb9c0f956447 },
+    { 0x8edf98b59a373fec, 0x4724bd4189bd5eac },
+    { 0xb2977ee300c50fe7, 0x58edec91ec2cb657 },
+    { 0xdf3d5e9bc0f653e1, 0x2f2967b66737e3ed },
+    { 0x8b865b215899f46c, 0xbd79e0d20082ee74 },
+    { 0xae67f1e9aec07187, 0xecd8590680a3aa11 },
+    { 0xda01ee641a708de9, 0xe80e6f4820cc9495 },
+    { 0x884134fe908658b2, 0x3109058d147fdcdd },
+    { 0xaa51823e34a7eede, 0xbd4b46f0599fd415 },
+    { 0xd4e5e2cdc1d1ea96, 0x6c9e18ac7007c91a },
+    { 0x850fadc09923329e, 0x03e2cf6bc604ddb0 },
+    { 0xa6539930bf6bff45, 0x84db8346b786151c },
+    { 0xcfe87f7cef46ff16, 0xe612641865679a63 },
+    { 0x81f14fae158c5f6e, 0x4fcb7e8f3f60c07e },
+    { 0xa26da3999aef7749, 0xe3be5e330f38f09d },
+    { 0xcb090c8001ab551c, 0x5cadf5bfd3072cc5 },
+    { 0xfdcb4fa002162a63, 0x73d9732fc7c8f7f6 },
+    { 0x9e9f11c4014dda7e, 0x2867e7fddcdd9afa },
+    { 0xc646d63501a1511d, 0xb281e1fd541501b8 },
+    { 0xf7d88bc24209a565, 0x1f225a7ca91a4226 },
+    { 0x9ae757596946075f, 0x3375788de9b06958 },
+    { 0xc1a12d2fc3978937, 0x0052d6b1641c83ae },
+    { 0xf209787bb47d6b84, 0xc0678c5dbd23a49a },
+    { 0x9745eb4d50ce6332, 0xf840b7ba963646e0 },
+    { 0xbd176620a501fbff, 0xb650e5a93bc3d898 },
+    { 0xec5d3fa8ce427aff, 0xa3e51f138ab4cebe },
+    { 0x93ba47c980e98cdf, 0xc66f336c36b10137 },
+    { 0xb8a8d9bbe123f017, 0xb80b0047445d4184 },
+    { 0xe6d3102ad96cec1d, 0xa60dc059157491e5 },
+    { 0x9043ea1ac7e41392, 0x87c89837ad68db2f },
+    { 0xb454e4a179dd1877, 0x29babe4598c311fb },
+    { 0xe16a1dc9d8545e94, 0xf4296dd6fef3d67a },
+    { 0x8ce2529e2734bb1d, 0x1899e4a65f58660c },
+    { 0xb01ae745b101e9e4, 0x5ec05dcff72e7f8f },
+    { 0xdc21a1171d42645d, 0x76707543f4fa1f73 },
+    { 0x899504ae72497eba, 0x6a06494a791c53a8 },
+    { 0xabfa45da0edbde69, 0x0487db9d17636892 },
+    { 0xd6f8d7509292d603, 0x45a9d2845d3c42b6 },
+    { 0x865b86925b9bc5c2, 0x0b8a2392ba45a9b2 },
+    { 0xa7f26836f282b732, 0x8e6cac7768d7141e },
+    { 0xd1ef0244af2364ff, 0x3207d795430cd926 },
+    { 0x8335616aed761f1f, 0x7f44e6bd49e807b8 },
+    { 0xa402b9c5a8d3a6e7, 0x5f16206c9c6209a6 },
+    { 0xcd036837130890a1, 0x36dba887c37a8c0f },
+    { 0x802221226be55a64, 0xc2494954da2c9789 },
+    { 0xa02aa96b06deb0fd, 0xf2db9baa10b7bd6c },
+    { 0xc83553c5c8965d3d, 0x6f92829494e5acc7 },
+    { 0xfa42a8b73abbf48c, 0xcb772339ba1f17f9 },
+    { 0x9c69a97284b578d7, 0xff2a760414536efb },
+    { 0xc38413cf25e2d70d, 0xfef5138519684aba },
+    { 0xf46518c2ef5b8cd1, 0x7eb258665fc25d69 },
+    { 0x98bf2f79d5993802, 0xef2f773ffbd97a61 },
+    { 0xbeeefb584aff8603, 0xaafb550ffacfd8fa },
+    { 0xeeaaba2e5dbf6784, 0x95ba2a53f983cf38 },
+    { 0x952ab45cfa97a0b2, 0xdd945a747bf26183 },
+    { 0xba756174393d88df, 0x94f971119aeef9e4 },
+    { 0xe912b9d1478ceb17, 0x7a37cd5601aab85d },
+    { 0x91abb422ccb812ee, 0xac62e055c10ab33a },
+    { 0xb616a12b7fe617aa, 0x577b986b314d6009 },
+    { 0xe39c49765fdf9d94, 0xed5a7e85fda0b80b },
+    { 0x8e41ade9fbebc27d, 0x14588f13be847307 },
+    { 0xb1d219647ae6b31c, 0x596eb2d8ae258fc8 },
+    { 0xde469fbd99a05fe3, 0x6fca5f8ed9aef3bb },
+    { 0x8aec23d680043bee, 0x25de7bb9480d5854 },
+    { 0xada72ccc20054ae9, 0xaf561aa79a10ae6a },
+    { 0xd910f7ff28069da4, 0x1b2ba1518094da04 },
+    { 0x87aa9aff79042286, 0x90fb44d2f05d0842 },
+    { 0xa99541bf57452b28, 0x353a1607ac744a53 },
+    { 0xd3fa922f2d1675f2, 0x42889b8997915ce8 },
+    { 0x847c9b5d7c2e09b7, 0x69956135febada11 },
+    { 0xa59bc234db398c25, 0x43fab9837e699095 },
+    { 0xcf02b2c21207ef2e, 0x94f967e45e03f4bb },
+    { 0x8161afb94b44f57d, 0x1d1be0eebac278f5 },
+    { 0xa1ba1ba79e1632dc, 0x6462d92a69731732 },
+    { 0xca28a291859bbf93, 0x7d7b8f7503cfdcfe },
+    { 0xfcb2cb35e702af78, 0x5cda735244c3d43e },
+    { 0x9defbf01b061adab, 0x3a0888136afa64a7 },
+    { 0xc56baec21c7a1916, 0x088aaa1845b8fdd0 },
+    { 0xf6c69a72a3989f5b, 0x8aad549e57273d45 },
+    { 0x9a3c2087a63f6399, 0x36ac54e2f678864b },
+    { 0xc0cb28a98fcf3c7f, 0x84576a1bb416a7dd },
+    { 0xf0fdf2d3f3c30b9f, 0x656d44a2a11c51d5 },
+    { 0x969eb7c47859e743, 0x9f644ae5a4b1b325 },
+    { 0xbc4665b596706114, 0x873d5d9f0dde1fee },
+    { 0xeb57ff22fc0c7959, 0xa90cb506d155a7ea },
+    { 0x9316ff75dd87cbd8, 0x09a7f12442d588f2 },
+    { 0xb7dcbf5354e9bece, 0x0c11ed6d538aeb2f },
+    { 0xe5d3ef282a242e81, 0x8f1668c8a86da5fa },
+    { 0x8fa475791a569d10, 0xf96e017d694487bc },
+    { 0xb38d92d760ec4455, 0x37c981dcc395a9ac },
+    { 0xe070f78d3927556a, 0x85bbe253f47b1417 },
+    { 0x8c469ab843b89562, 0x93956d7478ccec8e },
+    { 0xaf58416654a6babb, 0x387ac8d1970027b2 },
+    { 0xdb2e51bfe9d0696a, 0x06997b05fcc0319e },
+    { 0x88fcf317f22241e2, 0x441fece3bdf81f03 },
+    { 0xab3c2fddeeaad25a, 0xd527e81cad7626c3 },
+    { 0xd60b3bd56a5586f1, 0x8a71e223d8d3b074 },
+    { 0x85c7056562757456, 0xf6872d5667844e49 },
+    { 0xa738c6bebb12d16c, 0xb428f8ac016561db },
+    { 0xd106f86e69d785c7, 0xe13336d701beba52 },
+    { 0x82a45b450226b39c, 0xecc0024661173473 },
+    { 0xa34d721642b06084, 0x27f002d7f95d0190 },
+    { 0xcc20ce9bd35c78a5, 0x31ec038df7b441f4 },
+    { 0xff290242c83396ce, 0x7e67047175a15271 },
+    { 0x9f79a169bd203e41, 0x0f0062c6e984d386 },
+    { 0xc75809c42c684dd1, 0x52c07b78a3e60868 },
+    { 0xf92e0c3537826145, 0xa7709a56ccdf8a82 },
+    { 0x9bbcc7a142b17ccb, 0x88a66076400bb691 },
+    { 0xc2abf989935ddbfe, 0x6acff893d00ea435 },
+    { 0xf356f7ebf83552fe, 0x0583f6b8c4124d43 },
+    { 0x98165af37b2153de, 0xc3727a337a8b704a },
+    { 0xbe1bf1b059e9a8d6, 0x744f18c0592e4c5c },
+    { 0xeda2ee1c7064130c, 0x1162def06f79df73 },
+    { 0x9485d4d1c63e8be7, 0x8addcb5645ac2ba8 },
+    { 0xb9a74a0637ce2ee1, 0x6d953e2bd7173692 },
+    { 0xe8111c87c5c1ba99, 0xc8fa8db6ccdd0437 },
+    { 0x910ab1d4db9914a0, 0x1d9c9892400a22a2 },
+    { 0xb54d5e4a127f59c8, 0x2503beb6d00cab4b },
+    { 0xe2a0b5dc971f303a, 0x2e44ae64840fd61d },
+    { 0x8da471a9de737e24, 0x5ceaecfed289e5d2 },
+    { 0xb10d8e1456105dad, 0x7425a83e872c5f47 },
+    { 0xdd50f1996b947518, 0xd12f124e28f77719 },
+    { 0x8a5296ffe33cc92f, 0x82bd6b70d99aaa6f },
+    { 0xace73cbfdc0bfb7b, 0x636cc64d1001550b },
+    { 0xd8210befd30efa5a, 0x3c47f7e05401aa4e },
+    { 0x8714a775e3e95c78, 0x65acfaec34810a71 },
+    { 0xa8d9d1535ce3b396, 0x7f1839a741a14d0d },
+    { 0xd31045a8341ca07c, 0x1ede48111209a050 },
+    { 0x83ea2b892091e44d, 0x934aed0aab460432 },
+    { 0xa4e4b66b68b65d60, 0xf81da84d5617853f },
+    { 0xce1de40642e3f4b9, 0x36251260ab9d668e },
+    { 0x80d2ae83e9ce78f3, 0xc1d72b7c6b426019 },
+    { 0xa1075a24e4421730, 0xb24cf65b8612f81f },
+    { 0xc94930ae1d529cfc, 0xdee033f26797b627 },
+    { 0xfb9b7cd9a4a7443c, 0x169840ef017da3b1 },
+    { 0x9d412e0806e88aa5, 0x8e1f289560ee864e },
+    { 0xc491798a08a2ad4e, 0xf1a6f2bab92a27e2 },
+    { 0xf5b5d7ec8acb58a2, 0xae10af696774b1db },
+    { 0x9991a6f3d6bf1765, 0xacca6da1e0a8ef29 },
+    { 0xbff610b0cc6edd3f, 0x17fd090a58d32af3 },
+    { 0xeff394dcff8a948e, 0xddfc4b4cef07f5b0 },
+    { 0x95f83d0a1fb69cd9, 0x4abdaf101564f98e },
+    { 0xbb764c4ca7a4440f, 0x9d6d1ad41abe37f1 },
+    { 0xea53df5fd18d5513, 0x84c86189216dc5ed },
+    { 0x92746b9be2f8552c, 0x32fd3cf5b4e49bb4 },
+    { 0xb7118682dbb66a77, 0x3fbc8c33221dc2a1 },
+    { 0xe4d5e82392a40515, 0x0fabaf3feaa5334a },
+    { 0x8f05b1163ba6832d, 0x29cb4d87f2a7400e },
+    { 0xb2c71d5bca9023f8, 0x743e20e9ef511012 },
+    { 0xdf78e4b2bd342cf6, 0x914da9246b255416 },
+    { 0x8bab8eefb6409c1a, 0x1ad089b6c2f7548e },
+    { 0xae9672aba3d0c320, 0xa184ac2473b529b1 },
+    { 0xda3c0f568cc4f3e8, 0xc9e5d72d90a2741e },
+    { 0x8865899617fb1871, 0x7e2fa67c7a658892 },
+    { 0xaa7eebfb9df9de8d, 0xddbb901b98feeab7 },
+    { 0xd51ea6fa85785631, 0x552a74227f3ea565 },
+    { 0x8533285c936b35de, 0xd53a88958f87275f },
+    { 0xa67ff273b8460356, 0x8a892abaf368f137 },
+    { 0xd01fef10a657842c, 0x2d2b7569b0432d85 },
+    { 0x8213f56a67f6b29b, 0x9c3b29620e29fc73 },
+    { 0xa298f2c501f45f42, 0x8349f3ba91b47b8f },
+    { 0xcb3f2f7642717713, 0x241c70a936219a73 },
+    { 0xfe0efb53d30dd4d7, 0xed238cd383aa0110 },
+    { 0x9ec95d1463e8a506, 0xf4363804324a40aa },
+    { 0xc67bb4597ce2ce48, 0xb143c6053edcd0d5 },
+    { 0xf81aa16fdc1b81da, 0xdd94b7868e94050a },
+    { 0x9b10a4e5e9913128, 0xca7cf2b4191c8326 },
+    { 0xc1d4ce1f63f57d72, 0xfd1c2f611f63a3f0 },
+    { 0xf24a01a73cf2dccf, 0xbc633b39673c8cec },
+    { 0x976e41088617ca01, 0xd5be0503e085d813 },
+    { 0xbd49d14aa79dbc82, 0x4b2d8644d8a74e18 },
+    { 0xec9c459d51852ba2, 0xddf8e7d60ed1219e },
+    { 0x93e1ab8252f33b45, 0xcabb90e5c942b503 },
+    { 0xb8da1662e7b00a17, 0x3d6a751f3b936243 },
+    { 0xe7109bfba19c0c9d, 0x0cc512670a783ad4 },
+    { 0x906a617d450187e2, 0x27fb2b80668b24c5 },
+    { 0xb484f9dc9641e9da, 0xb1f9f660802dedf6 },
+    { 0xe1a63853bbd26451, 0x5e7873f8a0396973 },
+    { 0x8d07e33455637eb2, 0xdb0b487b6423e1e8 },
+    { 0xb049dc016abc5e5f, 0x91ce1a9a3d2cda62 },
+    { 0xdc5c5301c56b75f7, 0x7641a140cc7810fb },
+    { 0x89b9b3e11b6329ba, 0xa9e904c87fcb0a9d },
+    { 0xac2820d9623bf429, 0x546345fa9fbdcd44 },
+    { 0xd732290fbacaf133, 0xa97c177947ad4095 },
+    { 0x867f59a9d4bed6c0, 0x49ed8eabcccc485d },
+    { 0xa81f301449ee8c70, 0x5c68f256bfff5a74 },
+    { 0xd226fc195c6a2f8c, 0x73832eec6fff3111 },
+    { 0x83585d8fd9c25db7, 0xc831fd53c5ff7eab },
+    { 0xa42e74f3d032f525, 0xba3e7ca8b77f5e55 },
+    { 0xcd3a1230c43fb26f, 0x28ce1bd2e55f35eb },
+    { 0x80444b5e7aa7cf85, 0x7980d163cf5b81b3 },
+    { 0xa0555e361951c366, 0xd7e105bcc332621f },
+    { 0xc86ab5c39fa63440, 0x8dd9472bf3fefaa7 },
+    { 0xfa856334878fc150, 0xb14f98f6f0feb951 },
+    { 0x9c935e00d4b9d8d2, 0x6ed1bf9a569f33d3 },
+    { 0xc3b8358109e84f07, 0x0a862f80ec4700c8 },
+    { 0xf4a642e14c6262c8, 0xcd27bb612758c0fa },
+    { 0x98e7e9cccfbd7dbd, 0x8038d51cb897789c },
+    { 0xbf21e44003acdd2c, 0xe0470a63e6bd56c3 },
+    { 0xeeea5d5004981478, 0x1858ccfce06cac74 },
+    { 0x95527a5202df0ccb, 0x0f37801e0c43ebc8 },
+    { 0xbaa718e68396cffd, 0xd30560258f54e6ba },
+    { 0xe950df20247c83fd, 0x47c6b82ef32a2069 },
+    { 0x91d28b7416cdd27e, 0x4cdc331d57fa5441 },
+    { 0xb6472e511c81471d, 0xe0133fe4adf8e952 },
+    { 0xe3d8f9e563a198e5, 0x58180fddd97723a6 },
+    { 0x8e679c2f5e44ff8f, 0x570f09eaa7ea7648 },
+    { 0xb201833b35d63f73, 0x2cd2cc6551e513da },
+    { 0xde81e40a034bcf4f, 0xf8077f7ea65e58d1 },
+    { 0x8b112e86420f6191, 0xfb04afaf27faf782 },
+    { 0xadd57a27d29339f6, 0x79c5db9af1f9b563 },
+    { 0xd94ad8b1c7380874, 0x18375281ae7822bc },
+    { 0x87cec76f1c830548, 0x8f2293910d0b15b5 },
+    { 0xa9c2794ae3a3c69a, 0xb2eb3875504ddb22 },
+    { 0xd433179d9c8cb841, 0x5fa60692a46151eb },
+    { 0x849feec281d7f328, 0xdbc7c41ba6bcd333 },
+    { 0xa5c7ea73224deff3, 0x12b9b522906c0800 },
+    { 0xcf39e50feae16bef, 0xd768226b34870a00 },
+    { 0x81842f29f2cce375, 0xe6a1158300d46640 },
+    { 0xa1e53af46f801c53, 0x60495ae3c1097fd0 },
+    { 0xca5e89b18b602368, 0x385bb19cb14bdfc4 },
+    { 0xfcf62c1dee382c42, 0x46729e03dd9ed7b5 },
+    { 0x9e19db92b4e31ba9, 0x6c07a2c26a8346d1 },
+};
+
+static const double json_exact_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+bool json_is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+void json_mul128(uint64_t a, uint64_t b, uint64_t* hi, uint64_t* lo) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = (unsigned __int128)a * b;
+    *hi = (uint64_t)(r >> 64);
+    *lo = (uint64_t)r;
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+    uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+    *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    *lo = (mid << 32) | (uint32_t)ll;
+#endif
+}
+
+// Eisel-Lemire: the correctly rounded double closest to w * 10^q for a
+// non zero w, computed from one or two 64x64 bit products.
+double json_eisel_lemire(uint64_t w, int64_t q) {
+    if (w == 0 || q < JSON_POW5_MIN) return 0.0;
+    if (q > JSON_POW5_MAX) return HUGE_VAL;
+
+    int lz = __builtin_clzll(w);
+    w <<= lz;
+
+    const uint64_t* pow5 = json_pow5_table[q - JSON_POW5_MIN];
+    uint64_t hi, lo;
+    json_mul128(w, pow5[0], &hi, &lo);
+    if ((hi & 0x1FF) == 0x1FF) {
+        uint64_t hi2, lo2;
+        json_mul128(w, pow5[1], &hi2, &lo2);
+        lo += hi2;
+        if (hi2 > lo) hi++;
+    }
+
+    int upperbit = (int)(hi >> 63);
+    int shift = upperbit + 9;
+    uint64_t mantissa = hi >> shift;
+    int64_t power2 = ((((152170 + 65536) * (int32_t)q) >> 16) + 63) + upperbit - lz + 1023;
+
+    if (power2 <= 0) {
+        // Subnormal
+        if (-power2 + 1 >= 64) return 0.0;
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        power2 = mantissa < ((uint64_t)1 << 52) ? 0 : 1;
+    } else {
+        // Exactly halfway between two doubles: round to even
+        if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == hi) {
+            mantissa &= ~(uint64_t)1;
+        }
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        if (mantissa >= ((uint64_t)2 << 52)) {
+            mantissa = (uint64_t)1 << 52;
+            power2++;
+        }
+        mantissa &= ~((uint64_t)1 << 52);
+        if (power2 >= 0x7FF) return HUGE_VAL;
+    }
+
+    uint64_t bits = mantissa | ((uint64_t)power2 << 52);
+    double result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+#define JSON_MAX_DIGITS 19
+
+// The halfway point between two doubles has at most 768 significant
+// digits, the ones after those only matter for breaking a tie.
+#define JSON_BIGINT_DIGITS 768
+#define JSON_BIGINT_LIMBS 160
+
+// Unsigned integer of up to JSON_BIGINT_LIMBS 32 bit limbs, least
+// significant first, without leading zero limbs.
+typedef struct {
+    uint32_t limbs[JSON_BIGINT_LIMBS];
+    size_t len;
+}JsonBigint;
+
+void json_bigint_mul_add(JsonBigint* n, uint32_t mul, uint32_t add) {
+    uint64_t carry = add;
+    for (size_t i = 0; i < n->len; ++i) {
+        carry += (uint64_t)n->limbs[i] * mul;
+        n->limbs[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    if (carry != 0) {
+        ALI_ASSERT(n->len < JSON_BIGINT_LIMBS);
+        n->limbs[n->len++] = (uint32_t)carry;
+    }
+}
+
+void json_bigint_mul_pow5(JsonBigint* n, int64_t e) {
+    for (; e >= 13; e -= 13) json_bigint_mul_add(n, 1220703125, 0);
+    uint32_t mul = 1;
+    for (; e > 0; --e) mul *= 5;
+    json_bigint_mul_add(n, mul, 0);
+}
+
+void json_bigint_shl(JsonBigint* n, int64_t bits) {
+    if (n->len == 0) return;
+    size_t limbs = bits / 32, shift = bits % 32;
+    ALI_ASSERT(n->len + limbs < JSON_BIGINT_LIMBS);
+    n->limbs[n->len] = 0;
+    for (size_t i = n->len + 1; i-- > 0;) {
+        uint32_t low = i > 0 && shift != 0 ? n->limbs[i - 1] >> (32 - shift) : 0;
+        n->limbs[i + limbs] = (n->limbs[i] << shift) | low;
+    }
+    memset(n->limbs, 0, limbs * sizeof(n->limbs[0]));
+    n->len += limbs + 1;
+    while (n->len > 0 && n->limbs[n->len - 1] == 0) n->len--;
+}
+
+int json_bigint_cmp(const JsonBigint* a, const JsonBigint* b) {
+    if (a->len != b->len) return a->len < b->len ? -1 : 1;
+    for (size_t i = a->len; i-- > 0;) {
+        if (a->limbs[i] != b->limbs[i]) return a->limbs[i] < b->limbs[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// Rounds the number literal in [p, end), whose magnitude lies between
+// the non negative `low` and the next double up, to the nearer of the
+// two. The digits are compared with their halfway point as integers, so
+// the result is exact and doesn't depend on the locale like strtod.
+double json_round_decimal(const char* p, const char* end, double low) {
+    JsonBigint digits = {0};
+    int64_t exponent = 0;
+    size_t count = 0;
+    bool fraction = false, tail = false;
+    uint32_t chunk = 0, scale = 1;
+    for (; p < end && *p != 'e' && *p != 'E'; ++p) {
+        if (*p == '-') continue;
+        if (*p == '.') {
+            fraction = true;
+            continue;
+        }
+        if (count == JSON_BIGINT_DIGITS) {
+            tail |= *p != '0';
+            if (!fraction) exponent++;
+            continue;
+        }
+        if (fraction) exponent--;
+        if (count == 0 && *p == '0') continue;
+
+        chunk = chunk * 10 + (*p - '0');
+        scale *= 10;
+        count++;
+        if (scale == 1000000000) {
+            json_bigint_mul_add(&digits, scale, chunk);
+            chunk = 0;
+            scale = 1;
+        }
+    }
+    json_bigint_mul_add(&digits, scale, chunk);
+
+    if (p < end) {
+        p++;
+        bool negative = *p == '-';
+        if (*p == '-' || *p == '+') p++;
+        int64_t exp = 0;
+        for (; p < end && json_is_digit(*p); ++p) {
+            if (exp < 100000) exp = exp * 10 + (*p - '0');
+        }
+        exponent += negative ? -exp : exp;
+    }
+
+    // low is m * 2^e2, the halfway point (2m + 1) * 2^(e2 - 1)
+    uint64_t bits;
+    memcpy(&bits, &low, sizeof(bits));
+    uint64_t biased = bits >> 52;
+    uint64_t m = bits & (((uint64_t)1 << 52) - 1);
+    int64_t e2 = biased == 0 ? -1074 : (int64_t)biased - 1075;
+    if (biased != 0) m |= (uint64_t)1 << 52;
+
+    JsonBigint halfway = {0};
+    uint64_t h = 2 * m + 1;
+    halfway.limbs[0] = (uint32_t)h;
+    halfway.limbs[1] = (uint32_t)(h >> 32);
+    halfway.len = halfway.limbs[1] != 0 ? 2 : 1;
+
+    // digits * 5^exponent * 2^exponent against halfway, with each factor
+    // moved to the side where its power is positive
+    int64_t shift = exponent - (e2 - 1);
+    if (exponent >= 0) json_bigint_mul_pow5(&digits, exponent);
+    else json_bigint_mul_pow5(&halfway, -exponent);
+    if (shift >= 0) json_bigint_shl(&digits, shift);
+    else json_bigint_shl(&halfway, -shift);
+
+    int cmp = json_bigint_cmp(&digits, &halfway);
+    if (cmp == 0 && tail) cmp = 1;
+    // A tie rounds to the even mantissa
+    if (cmp > 0 || (cmp == 0 && (m & 1) != 0)) bits++;
+
+    double result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// Parses a JSON number from [p, end) without reading past `end`, and
+// stores where it stopped in `*endptr`, even when it fails.
+bool json_parse_number(const char* p, const char* end, JsonNumber* out, const char** endptr) {
+    const char* start = p;
+    bool negative = p < end && *p == '-';
+    if (negative) p++;
+    if (p >= end || !json_is_digit(*p)) {
+        *endptr = p;
+        return false;
+    }
+
+    uint64_t mantissa = 0;
+    int64_t exponent = 0;
+    int digits = 0;
+    bool truncated = false;
+    bool is_integer = true;
+
+    if (*p == '0') {
+        p++;
+    } else {
+        for (; p < end && json_is_digit(*p); ++p) {
+            if (digits < JSON_MAX_DIGITS) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits++;
+            } else {
+                truncated |= *p != '0';
+                exponent++;
+            }
+        }
+    }
+
+    if (p < end && *p == '.') {
+        p++;
+        if (p >= end || !json_is_digit(*p)) {
+            *endptr = p;
+            return false;
+        }
+        is_integer = false;
+        for (; p < end && json_is_digit(*p); ++p) {
+            if (digits < JSON_MAX_DIGITS) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa != 0) digits++;
+                exponent--;
+            } else {
+                truncated |= *p != '0';
+            }
+        }
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool exp_negative = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) p++;
+        if (p >= end || !json_is_digit(*p)) {
+            *endptr = p;
+            return false;
+        }
+        is_integer = false;
+
+        int64_t exp = 0;
+        for (; p < end && json_is_digit(*p); ++p) {
+            if (exp < 100000) exp = exp * 10 + (*p - '0');
+        }
+        exponent += exp_negative ? -exp : exp;
+    }
+    *endptr = p;
+
+    out->is_integer = is_integer && !truncated && exponent == 0 && mantissa <= (uint64_t)INT64_MAX + negative;
+    if (out->is_integer) out->integer = negative ? (int64_t)(0 - mantissa) : (int64_t)mantissa;
+
+    double value;
+    if (!truncated && mantissa <= ((uint64_t)1 << 53) && exponent >= -22 && exponent <= 22) {
+        // Clinger's fast path: both operands are exact, so is the result
+        value = (double)mantissa;
+        value = exponent < 0 ? value / json_exact_pow10[-exponent] : value * json_exact_pow10[exponent];
+    } else if (!truncated) {
+        value = json_eisel_lemire(mantissa, exponent);
+    } else {
+        // More than 19 significant digits. When both neighbours of the
+        // truncated mantissa round to the same double, that's the answer,
+        // otherwise all the digits decide between the two.
+        value = json_eisel_lemire(mantissa, exponent);
+        if (value != json_eisel_lemire(mantissa + 1, exponent)) value = json_round_decimal(start, p, value);
+    }
+
+    out->number = negative ? -value : value;
+    return true;
+}
+
+const char* json_lexer_end(JsonLexer* lexer) {
+    return lexer->content_start + lexer->content_len;
+}
+
+bool json_is_empty(JsonLexer* lexer) {
+    return lexer->cursor >= json_lexer_end(lexer);
+}
+
+void json_lexer_trim_left(JsonLexer* lexer) {
+    lexer->cursor = json_skip_whitespace(lexer->cursor, json_lexer_end(lexer));
+}
+
+// Moves the cursor to the closing quote of the string it is in.
+// Escape sequences are stepped over but not decoded.
+void json_lexer_skip_string_body(JsonLexer* lexer) {
+    const char* end = json_lexer_end(lexer);
+    lexer->cursor = json_scan_string(lexer->cursor, end);
+    while (lexer->cursor < end && *lexer->cursor == '\\') {
+        lexer->cursor += end - lexer->cursor >= 2 ? 2 : 1;
+        lexer->cursor = json_scan_string(lexer->cursor, end);
+    }
+}
+
+const char* json_error_message(JsonErrorCode code) {
+    switch (code) {
+        case JSON_ERROR_NONE: return "no error";
+        case JSON_ERROR_EOF: return "unexpected end of input";
+        case JSON_ERROR_UNEXPECTED_CHAR: return "unexpected char";
+        case JSON_ERROR_NUMBER: return "invalid number";
+        case JSON_ERROR_TYPE: return "value doesn't match the field type";
+        case JSON_ERROR_CALLBACK: return "stopped by a callback";
+        case JSON_ERROR_DEPTH: return "nested too deeply";
+        case JSON_ERROR_STRING: return "invalid string";
+        case JSON_ERROR_UTF8: return "invalid UTF-8";
+    }
+    return "unknown error";
+}
+
+void json_error_position(const char* content_start, size_t offset, size_t* line, size_t* column) {
+    const char* end = content_start + offset;
+    const char* line_start = content_start;
+    *line = 1;
+    for (const char* p = json_scan_newline(content_start, end); p < end; p = json_scan_newline(p + 1, end)) {
+        line_start = p + 1;
+        ++*line;
+    }
+    *column = end - line_start + 1;
+}
+
+void json_lexer_error_position(JsonLexer* lexer, size_t* line, size_t* column) {
+    json_error_position(lexer->content_start, lexer->error.offset, line, column);
+}
+
+// Records the error at the cursor. Returns false so that it can end a parse.
+bool json_lexer_fail(JsonLexer* lexer, JsonErrorCode code, char expected) {
+    lexer->error.code = code;
+    lexer->error.offset = lexer->cursor - lexer->content_start;
+    lexer->error.expected = expected;
+    return false;
+}
+
+bool json_lexer_expect_char(JsonLexer* lexer, char c) {
+    if (json_is_empty(lexer)) return json_lexer_fail(lexer, JSON_ERROR_EOF, c);
+    if (*lexer->cursor != c) return json_lexer_fail(lexer, JSON_ERROR_UNEXPECTED_CHAR, c);
+    lexer->cursor++;
+    return true;
+}
+
+// Strings
+
+// ali_codepoint_to_utf8 returns a static buffer, which parallel parses
+// would share.
+void json_sb_push_codepoint(AliSb* sb, uint32_t codepoint) {
+    char utf8[4];
+    size_t len;
+    if (codepoint < 0x80) {
+        utf8[0] = codepoint;
+        len = 1;
+    } else if (codepoint < 0x800) {
+        utf8[0] = 0xc0 | (codepoint >> 6);
+        utf8[1] = 0x80 | (codepoint & 0x3f);
+        len = 2;
+    } else if (codepoint < 0x10000) {
+        utf8[0] = 0xe0 | (codepoint >> 12);
+        utf8[1] = 0x80 | ((codepoint >> 6) & 0x3f);
+        utf8[2] = 0x80 | (codepoint & 0x3f);
+        len = 3;
+    } else {
+        utf8[0] = 0xf0 | (codepoint >> 18);
+        utf8[1] = 0x80 | ((codepoint >> 12) & 0x3f);
+        utf8[2] = 0x80 | ((codepoint >> 6) & 0x3f);
+        utf8[3] = 0x80 | (codepoint & 0x3f);
+        len = 4;
+    }
+    json_sb_push(sb, utf8, len);
+}
+
+// Reads the four hex digits of a \u escape, `p` is on the backslash.
+bool json_parse_hex_escape(const char* p, const char* end, uint32_t* out) {
+    if (end - p < 6 || p[0] != '\\' || p[1] != 'u') return false;
+    uint32_t value = 0;
+    for (size_t i = 2; i < 6; ++i) {
+        char c = p[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return false;
+        value = value << 4 | digit;
+    }
+    *out = value;
+    return true;
+}
+
+// Appends the char of the escape sequence at `escape` to `sb`. Surrogate
+// pairs are joined, unpaired surrogates become U+FFFD. Returns the end of
+// the sequence, or NULL when it is invalid.
+const char* json_unescape(AliSb* sb, const char* escape, const char* end) {
+    if (end - escape < 2) return NULL;
+
+    char c = escape[1];
+    switch (c) {
+        case '"':
+        case '\\':
+        case '/': json_sb_push(sb, &c, 1); return escape + 2;
+        case 'b': json_sb_push(sb, "\b", 1); return escape + 2;
+        case 'f': json_sb_push(sb, "\f", 1); return escape + 2;
+        case 'n': json_sb_push(sb, "\n", 1); return escape + 2;
+        case 'r': json_sb_push(sb, "\r", 1); return escape + 2;
+        case 't': json_sb_push(sb, "\t", 1); return escape + 2;
+        case 'u': break;
+        default: return NULL;
+    }
+
+    uint32_t codepoint;
+    if (!json_parse_hex_escape(escape, end, &codepoint)) return NULL;
+    const char* p = escape + 6;
+    if (codepoint >= 0xdc00 && codepoint <= 0xdfff) {
+        codepoint = 0xfffd;
+    } else if (codepoint >= 0xd800 && codepoint <= 0xdbff) {
+        uint32_t low;
+        if (json_parse_hex_escape(p, end, &low) && low >= 0xdc00 && low <= 0xdfff) {
+            codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+            p += 6;
+        } else {
+            codepoint = 0xfffd;
+        }
+    }
+    json_sb_push_codepoint(sb, codepoint);
+    return p;
+}
+
+// Call on the byte json_scan_string_body stopped at. True for '"' and
+// '\\', otherwise fails with why the string can't go on.
+bool json_lexer_string_stop(JsonLexer* lexer) {
+    if (json_is_empty(lexer)) return json_lexer_fail(lexer, JSON_ERROR_EOF, '"');
+    unsigned char c = *lexer->cursor;
+    if (c == '"' || c == '\\') return true;
+    return json_lexer_fail(lexer, c < 0x20 ? JSON_ERROR_STRING : JSON_ERROR_UTF8, 0);
+}
+
+// Fails on the invalid escape sequence at the cursor.
+bool json_lexer_fail_escape(JsonLexer* lexer) {
+    return json_lexer_fail(lexer, json_lexer_end(lexer) - lexer->cursor < 2 ? JSON_ERROR_EOF : JSON_ERROR_STRING, 0);
+}
+
+// The cursor must be past the opening quote, it ends past the closing one.
+// Strings without escapes, found with one scan, are returned as views of
+// the input. The others are decoded into `unescaped` in the same pass.
+bool json_lexer_read_string(JsonLexer* lexer, AliSb* unescaped, AliSv* out) {
+    const char* start = lexer->cursor;
+    const char* end = json_lexer_end(lexer);
+    lexer->cursor = json_scan_string_body(start, end);
+    if (lexer->cursor < end && *lexer->cursor == '"') {
+        *out = ali_sv_from_parts((char*)start, lexer->cursor - start);
+        lexer->cursor++;
+        return true;
+    }
+
+    unescaped->count = 0;
+    for (;;) {
+        json_sb_push(unescaped, start, lexer->cursor - start);
+        if (!json_lexer_string_stop(lexer)) return false;
+        if (*lexer->cursor == '"') break;
+
+        const char* next = json_unescape(unescaped, lexer->cursor, end);
+        if (next == NULL) return json_lexer_fail_escape(lexer);
+        start = next;
+        lexer->cursor = json_scan_string_body(next, end);
+    }
+
+    lexer->cursor++;
+    *out = ali_sv_from_parts(unescaped->data, unescaped->count);
+    return true;
+}
+
+// Events
+
+#define JSON_DOM_NO_FRAME ((size_t)-1)
+
+// Open containers live on the builder's scratch stack, directly below
+// their children.
+typedef struct {
+    size_t parent;
+    JsonValueType type;
+    AliSv key; // key of the item whose value is being parsed
+}JsonDomFrame;
+
+JsonDomBuilder json_dom_builder(AliArena* arena, unsigned flags) {
+    JsonDomBuilder builder = {0};
+    builder.arena = arena;
+    builder.flags = flags;
+    builder.top = JSON_DOM_NO_FRAME;
+    return builder;
+}
+
+void json_dom_builder_free(JsonDomBuilder* builder) {
+    ali_sb_free(&builder->scratch);
+}
+
+// Builds into the lexer's arena, with views into its input
+JsonDomBuilder json_lexer_dom_builder(JsonLexer* lexer) {
+    JsonDomBuilder builder = json_dom_builder(json_lexer_arena(lexer), lexer->flags);
+    builder.intern = &lexer->intern;
+    builder.views_start = lexer->content_start;
+    builder.views_end = json_lexer_end(lexer);
+    return builder;
+}
+
+JsonDomFrame* json_dom_top(JsonDomBuilder* builder) {
+    return (JsonDomFrame*)(builder->scratch.data + builder->top);
+}
+
+AliSv json_dom_string(JsonDomBuilder* builder, const char* string, size_t len, bool key) {
+    bool view = (builder->flags & JSON_PARSE_VIEWS) && string >= builder->views_start && string < builder->views_end;
+    if ((builder->flags & JSON_PARSE_INTERN) && (key || len <= JSON_INTERN_MAX_LEN)) {
+#ifdef JSON_STATS
+        size_t interned = builder->intern->len;
+        AliSv canonical = json_intern(builder->intern, view ? NULL : builder->arena, string, len);
+        bool copied = builder->intern->len > interned && !view;
+        if (builder->stats != NULL && copied) builder->stats->string_bytes += len;
+        return canonical;
+#else
+        return json_intern(builder->intern, view ? NULL : builder->arena, string, len);
+#endif // JSON_STATS
+    }
+    if (view) return ali_sv_from_parts((char*)string, len);
+
+#ifdef JSON_STATS
+    if (builder->stats != NULL) builder->stats->string_bytes += len;
+#endif // JSON_STATS
+    return ali_sv_from_parts(json_strndup(builder->arena, string, len), len);
+}
+
+bool json_dom_emit(JsonDomBuilder* builder, JsonValue value) {
+#ifdef JSON_STATS
+    if (builder->stats != NULL) builder->stats->nodes[value.type]++;
+#endif // JSON_STATS
+
+    if (builder->top == JSON_DOM_NO_FRAME) {
+        builder->root = value;
+        builder->done = true;
+        return true;
+    }
+
+    JsonDomFrame* top = json_dom_top(builder);
+    if (top->type == JSON_ARRAY) {
+        json_scratch_push(&builder->scratch, &value, sizeof(value));
+    } else {
+        JsonObjectItem item = { top->key, value };
+        json_scratch_push(&builder->scratch, &item, sizeof(item));
+    }
+    return true;
+}
+
+bool json_dom_open(JsonDomBuilder* builder, JsonValueType type) {
+    JsonDomFrame frame = { builder->top, type, {0} };
+    builder->top = builder->scratch.count;
+    json_scratch_push(&builder->scratch, &frame, sizeof(frame));
+
+#ifdef JSON_STATS
+    builder->depth++;
+    if (builder->stats != NULL && builder->depth > builder->stats->max_depth) builder->stats->max_depth = builder->depth;
+#endif // JSON_STATS
+    return true;
+}
+
+bool json_dom_close(JsonDomBuilder* builder) {
+    size_t frame_offset = builder->top;
+    JsonDomFrame frame = *json_dom_top(builder);
+    size_t base = frame_offset + sizeof(JsonDomFrame);
+
+#ifdef JSON_STATS
+    builder->depth--;
+    double start = 0;
+    if (builder->stats != NULL) {
+        if (builder->scratch.count > builder->stats->scratch_peak) builder->stats->scratch_peak = builder->scratch.count;
+        start = ali_get_now();
+    }
+#endif // JSON_STATS
+
+    JsonValue value = frame.type == JSON_ARRAY
+        ? json_commit_array(&builder->scratch, builder->arena, base)
+        : json_commit_object(&builder->scratch, builder->arena, base);
+    builder->scratch.count = frame_offset;
+    builder->top = frame.parent;
+
+#ifdef JSON_STATS
+    if (builder->stats != NULL) builder->stats->commit_seconds += ali_get_now() - start;
+#endif // JSON_STATS
+    return json_dom_emit(builder, value);
+}
+
+bool json_dom_on_object_begin(void* user) {
+    return json_dom_open(user, JSON_OBJECT);
+}
+
+bool json_dom_on_array_begin(void* user) {
+    return json_dom_open(user, JSON_ARRAY);
+}
+
+bool json_dom_on_end(void* user) {
+    return json_dom_close(user);
+}
+
+bool json_dom_on_key(void* user, const char* key, size_t len) {
+    JsonDomBuilder* builder = user;
+    json_dom_top(builder)->key = json_dom_string(builder, key, len, true);
+    return true;
+}
+
+bool json_dom_on_string(void* user, const char* string, size_t len) {
+    JsonDomBuilder* builder = user;
+    JsonValue value;
+    if (!json_value_inline(&value, string, len)) {
+        value = (JsonValue) { .type = JSON_STRING, .as.string = json_dom_string(builder, string, len, false) };
+    }
+    return json_dom_emit(builder, value);
+}
+
+bool json_dom_on_number(void* user, double number) {
+    return json_dom_emit(user, json_value_number(number));
+}
+
+bool json_dom_on_integer(void* user, int64_t integer) {
+    return json_dom_emit(user, json_value_integer(integer));
+}
+
+bool json_dom_on_boolean(void* user, bool boolean) {
+    return json_dom_emit(user, json_value_boolean(boolean));
+}
+
+bool json_dom_on_null(void* user) {
+    return json_dom_emit(user, json_value_null());
+}
+
+const JsonSax json_dom_sax = {
+    .on_object_begin = json_dom_on_object_begin,
+    .on_object_end = json_dom_on_end,
+    .on_array_begin = json_dom_on_array_begin,
+    .on_array_end = json_dom_on_end,
+    .on_key = json_dom_on_key,
+    .on_string = json_dom_on_string,
+    .on_number = json_dom_on_number,
+#if JSON_INTEGERS
+    .on_integer = json_dom_on_integer,
+#endif // JSON_INTEGERS
+    .on_boolean = json_dom_on_boolean,
+    .on_null = json_dom_on_null,
+};
+
+#ifndef JSON_MAX_DEPTH
+#define JSON_MAX_DEPTH 1024
+#endif // JSON_MAX_DEPTH
+
+#define JSON_SAX_EMIT(sax, callback, ...) ((sax)->callback == NULL || (sax)->callback(__VA_ARGS__))
+#define JSON_LEXER_EMIT(lexer, sax, callback, ...) \
+    (JSON_SAX_EMIT(sax, callback, __VA_ARGS__) || json_lexer_fail(lexer, JSON_ERROR_CALLBACK, 0))
+
+// -0 stays a double, an integer would lose the sign
+bool json_sax_emit_number(const JsonSax* sax, void* user, JsonNumber* number) {
+    bool integer = number->is_integer && (number->integer != 0 || !signbit(number->number));
+    if (integer && sax->on_integer != NULL) return sax->on_integer(user, number->integer);
+    return JSON_SAX_EMIT(sax, on_number, user, number->number);
+}
+
+// The literal at [p, end) that is one of true, false and null. Returns
+// its length, or 0 when the input has none of them. `*partial` is set
+// when the input ends inside one.
+size_t json_literal_len(const char* p, const char* end, bool* partial) {
+    const char* literal = *p == 't' ? "true" : *p == 'f' ? "false" : *p == 'n' ? "null" : NULL;
+    *partial = false;
+    if (literal == NULL) return 0;
+
+    size_t len = strlen(literal);
+    size_t left = end - p;
+    size_t n = left < len ? left : len;
+    if (memcmp(p, literal, n) != 0) return 0;
+    *partial = n < len;
+    return n < len ? 0 : len;
+}
+
+bool json_lexer_parse_scalar(JsonLexer* lexer, const JsonSax* sax, void* user) {
+    if (*lexer->cursor == '-' || json_is_digit(*lexer->cursor)) {
+        JsonNumber number;
+        if (!json_parse_number(lexer->cursor, json_lexer_end(lexer), &number, &lexer->cursor)) {
+            return json_lexer_fail(lexer, JSON_ERROR_NUMBER, 0);
+        }
+        return json_sax_emit_number(sax, user, &number) || json_lexer_fail(lexer, JSON_ERROR_CALLBACK, 0);
+    }
+
+    if (*lexer->cursor == '"') {
+        lexer->cursor++;
+        AliSv string;
+        if (!json_lexer_read_string(lexer, &lexer->unescaped, &string)) return false;
+        return JSON_LEXER_EMIT(lexer, sax, on_string, user, string.start, string.len);
+    }
+
+    size_t left = json_lexer_end(lexer) - lexer->cursor;
+    if (left >= 4 && memcmp(lexer->cursor, "true", 4) == 0) {
+        lexer->cursor += 4;
+        return JSON_LEXER_EMIT(lexer, sax, on_boolean, user, true);
+    }
+    if (left >= 5 && memcmp(lexer->cursor, "false", 5) == 0) {
+        lexer->cursor += 5;
+        return JSON_LEXER_EMIT(lexer, sax, on_boolean, user, false);
+    }
+    if (left >= 4 && memcmp(lexer->cursor, "null", 4) == 0) {
+        lexer->cursor += 4;
+        return JSON_LEXER_EMIT(lexer, sax, on_null, user);
+    }
+    return json_lexer_fail(lexer, JSON_ERROR_UNEXPECTED_CHAR, 0);
+}
+
+// Reads a key and the colon after it
+bool json_lexer_parse_key(JsonLexer* lexer, const JsonSax* sax, void* user) {
+    json_lexer_trim_left(lexer);
+    if (!json_lexer_expect_char(lexer, '"')) return false;
+    AliSv key;
+    if (!json_lexer_read_string(lexer, &lexer->unescaped, &key)) return false;
+    if (!JSON_LEXER_EMIT(lexer, sax, on_key, user, key.start, key.len)) return false;
+
+    json_lexer_trim_left(lexer);
+    return json_lexer_expect_char(lexer, ':');
+}
+
+// Open containers are pushed on lexer->containers above `base`, so the
+// call depth stays the same however deep the input is nested.
+bool json_lexer_parse_sax_from(JsonLexer* lexer, const JsonSax* sax, void* user, size_t base) {
+    size_t max_depth = lexer->max_depth > 0 ? lexer->max_depth : JSON_MAX_DEPTH;
+
+    for (;;) {
+        json_lexer_trim_left(lexer);
+        if (json_is_empty(lexer)) return json_lexer_fail(lexer, JSON_ERROR_EOF, 0);
+
+        char c = *lexer->cursor;
+        if (c == '[' || c == '{') {
+            if (lexer->containers.count - base >= max_depth) return json_lexer_fail(lexer, JSON_ERROR_DEPTH, 0);
+            lexer->cursor++;
+            bool ok = c == '['
+                ? JSON_LEXER_EMIT(lexer, sax, on_array_begin, user)
+                : JSON_LEXER_EMIT(lexer, sax, on_object_begin, user);
+            if (!ok) return false;
+            json_sb_push(&lexer->containers, &c, 1);
+
+            // Empty containers go straight to the closing loop below
+            json_lexer_trim_left(lexer);
+            if (json_is_empty(lexer) || *lexer->cursor != (c == '[' ? ']' : '}')) {
+                if (c == '{' && !json_lexer_parse_key(lexer, sax, user)) return false;
+                continue;
+            }
+        } else if (!json_lexer_parse_scalar(lexer, sax, user)) {
+            return false;
+        }
+
+        // A value is complete, close containers until the next value starts
+        for (;;) {
+            if (lexer->containers.count == base) return true;
+            char open = lexer->containers.data[lexer->containers.count - 1];
+
+            json_lexer_trim_left(lexer);
+            if (!json_is_empty(lexer) && *lexer->cursor == ',') {
+                lexer->cursor++;
+                if (open == '{' && !json_lexer_parse_key(lexer, sax, user)) return false;
+                break;
+            }
+            if (!json_lexer_expect_char(lexer, open == '[' ? ']' : '}')) return false;
+            lexer->containers.count--;
+
+            bool ok = open == '['
+                ? JSON_LEXER_EMIT(lexer, sax, on_array_end, user)
+                : JSON_LEXER_EMIT(lexer, sax, on_object_end, user);
+            if (!ok) return false;
+        }
+    }
+}
+
+bool json_lexer_parse_sax(JsonLexer* lexer, const JsonSax* sax, void* user) {
+    size_t base = lexer->containers.count;
+    bool ok = json_lexer_parse_sax_from(lexer, sax, user, base);
+    lexer->containers.count = base;
+    return ok;
+}
+
+// The tree is built from the lexer's events. The builder borrows the
+// lexer's scratch stack, so it stays warm across parses.
+bool json_lexer_parse_value(JsonLexer* lexer, JsonValue* value) {
+    JsonDomBuilder builder = json_lexer_dom_builder(lexer);
+    builder.scratch = lexer->scratch;
+    builder.scratch.count = 0;
+
+#ifdef JSON_STATS
+    JsonStats* stats = &lexer->stats;
+    builder.stats = stats;
+    const char* cursor = lexer->cursor;
+    double start = ali_get_now();
+#endif // JSON_STATS
+
+    bool ok = json_lexer_parse_sax(lexer, &json_dom_sax, &builder);
+    lexer->scratch = builder.scratch;
+
+#ifdef JSON_STATS
+    stats->parses++;
+    stats->bytes += lexer->cursor - cursor;
+    stats->parse_seconds += ali_get_now() - start;
+    stats->arena_bytes = json_arena_used(builder.arena);
+    if (stats->arena_bytes > stats->arena_peak) stats->arena_peak = stats->arena_bytes;
+#endif // JSON_STATS
+
+    if (!ok) return false;
+
+    *value = builder.root;
+    return true;
+}
+
+void json_lexer_reset(JsonLexer* lexer, const char* content_start, size_t content_size) {
+    ali_arena_reset(json_lexer_arena(lexer));
+    // Interned strings lived in the arena or in the old input
+    json_intern_clear(&lexer->intern);
+    lexer->content_start = content_start;
+    lexer->content_len = content_size;
+    lexer->cursor = content_start;
+    lexer->error = (JsonError) {0};
+}
+
+size_t json_lexer_parse_many(JsonLexer* lexer, const AliSv* documents, size_t count, JsonDocumentFn fn, void* user) {
+    for (size_t i = 0; i < count; ++i) {
+        json_lexer_reset(lexer, documents[i].start, documents[i].len);
+
+        JsonValue value;
+        if (!json_lexer_parse_value(lexer, &value)) return i;
+        json_lexer_trim_left(lexer);
+        if (!json_is_empty(lexer)) {
+            json_lexer_fail(lexer, JSON_ERROR_UNEXPECTED_CHAR, 0);
+            return i;
+        }
+        if (fn != NULL && !fn(user, i, &value)) {
+            json_lexer_fail(lexer, JSON_ERROR_CALLBACK, 0);
+            return i;
+        }
+    }
+    return count;
+}
+
+// Validation
+
+// Returns the end of the escape sequence at `escape` or NULL, like
+// json_unescape but without decoding it.
+const char* json_skip_escape(const char* escape, const char* end) {
+    if (end - escape < 2) return NULL;
+    uint32_t codepoint;
+    if (escape[1] == 'u') return json_parse_hex_escape(escape, end, &codepoint) ? escape + 6 : NULL;
+    return escape[1] != 0 && strchr("\"\\/bfnrt", escape[1]) != NULL ? escape + 2 : NULL;
+}
+
+// json_lexer_read_string without the decoding.
+bool json_validate_string(JsonLexer* lexer) {
+    const char* end = json_lexer_end(lexer);
+    for (;;) {
+        lexer->cursor = json_scan_string_body(lexer->cursor, end);
+        if (!json_lexer_string_stop(lexer)) return false;
+        if (*lexer->cursor == '"') {
+            lexer->cursor++;
+            return true;
+        }
+
+        const char* next = json_skip_escape(lexer->cursor, end);
+        if (next == NULL) return json_lexer_fail_escape(lexer);
+        lexer->cursor = next;
+    }
+}
+
+bool json_validate_key(JsonLexer* lexer) {
+    json_lexer_trim_left(lexer);
+    if (!json_lexer_expect_char(lexer, '"')) return false;
+    if (!json_validate_string(lexer)) return false;
+    json_lexer_trim_left(lexer);
+    return json_lexer_expect_char(lexer, ':');
+}
+
+bool json_validate_scalar(JsonLexer* lexer) {
+    char c = *lexer->cursor;
+    if (c == '"') {
+        lexer->cursor++;
+        return json_validate_string(lexer);
+    }
+
+    if (c == '-' || json_is_digit(c)) {
+        JsonNumber number;
+        if (!json_parse_number(lexer->cursor, json_lexer_end(lexer), &number, &lexer->cursor)) {
+            return json_lexer_fail(lexer, JSON_ERROR_NUMBER, 0);
+        }
+        return true;
+    }
+
+    size_t left = json_lexer_end(lexer) - lexer->cursor;
+    if (left >= 4 && memcmp(lexer->cursor, "true", 4) == 0) {
+        lexer->cursor += 4;
+        return true;
+    }
+    if (left >= 5 && memcmp(lexer->cursor, "false", 5) == 0) {
+        lexer->cursor += 5;
+        return true;
+    }
+    if (left >= 4 && memcmp(lexer->cursor, "null", 4) == 0) {
+        lexer->cursor += 4;
+        return true;
+    }
+    return json_lexer_fail(lexer, JSON_ERROR_UNEXPECTED_CHAR, 0);
+}
+
+// Same grammar as json_lexer_parse_sax, with the open containers one bit
+// each in `objects`, which holds `max_depth` bits.
+bool json_validate_lexer(JsonLexer* lexer, uint64_t* objects, size_t max_depth) {
+    size_t depth = 0;
+
+    for (;;) {
+        json_lexer_trim_left(lexer);
+        if (json_is_empty(lexer)) return json_lexer_fail(lexer, JSON_ERROR_EOF, 0);
+
+        char c = *lexer->cursor;
+        if (c == '[' || c == '{') {
+            if (depth == max_depth) return json_lexer_fail(lexer, JSON_ERROR_DEPTH, 0);
+            lexer->cursor++;
+
+            uint64_t bit = 1ull << (depth % 64);
+            if (c == '{') objects[depth / 64] |= bit;
+            else objects[depth / 64] &= ~bit;
+            depth++;
+
+            json_lexer_trim_left(lexer);
+            if (json_is_empty(lexer) || *lexer->cursor != (c == '[' ? ']' : '}')) {
+                if (c == '{' && !json_validate_key(lexer)) return false;
+                continue;
+            }
+            lexer->cursor++;
+            depth--;
+        } else if (!json_validate_scalar(lexer)) {
+            return false;
+        }
+
+        // A value is complete, close containers until the next one starts
+        for (;;) {
+            json_lexer_trim_left(lexer);
+            if (depth == 0) return json_is_empty(lexer) || json_lexer_fail(lexer, JSON_ERROR_UNEXPECTED_CHAR, 0);
+
+            bool object = (objects[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1;
+            if (!json_is_empty(lexer) && *lexer->cursor == ',') {
+                lexer->cursor++;
+                if (object && !json_validate_key(lexer)) return false;
+                break;
+            }
+            if (!json_lexer_expect_char(lexer, object ? '}' : ']')) return false;
+            depth--;
+        }
+    }
+}
+
+bool json_validate(const char* content_start, size_t content_size, size_t max_depth, JsonError* error) {
+    if (max_depth == 0) max_depth = JSON_MAX_DEPTH;
+    uint64_t buffer[(JSON_MAX_DEPTH + 63) / 64];
+    uint64_t* objects = max_depth <= JSON_MAX_DEPTH ? buffer : ALI_MALLOC((max_depth + 63) / 64 * sizeof(*objects));
+
+    JsonLexer lexer = json_lexer(content_start, content_size);
+    bool ok = json_validate_lexer(&lexer, objects, max_depth);
+    if (objects != buffer) ALI_FREE(objects);
+    if (error != NULL) *error = ok ? (JsonError) {0} : lexer.error;
+    return ok;
+}
+
+// Streaming
+
+JsonStream json_stream(AliArena* arena) {
+    JsonStream stream = {0};
+    stream.arena = arena;
+    stream.builder = json_dom_builder(arena, 0);
+    stream.state = JSON_STREAM_VALUE;
+    return stream;
+}
+
+JsonStream json_stream_sax(const JsonSax* sax, void* user) {
+    JsonStream stream = json_stream(NULL);
+    stream.sax = sax;
+    stream.user = user;
+    return stream;
+}
+
+void json_stream_free(JsonStream* stream) {
+    ali_arena_free(&stream->own_arena);
+    json_dom_builder_free(&stream->builder);
+    ali_sb_free(&stream->containers);
+    ali_sb_free(&stream->carry);
+    ali_sb_free(&stream->unescaped);
+}
+
+// Resolved on every use, like json_lexer_arena, since the builder cannot
+// keep a pointer into a stream that is passed around by value.
+const JsonSax* json_stream_sax_target(JsonStream* stream, void** user) {
+    if (stream->sax != NULL) {
+        *user = stream->user;
+        return stream->sax;
+    }
+    stream->builder.arena = stream->arena != NULL ? stream->arena : &stream->own_arena;
+    *user = &stream->builder;
+    return &json_dom_sax;
+}
+
+typedef enum {
+    JSON_STEP_OK,
+    JSON_STEP_MORE, // the token continues past the end of the input
+    JSON_STEP_ERROR,
+}JsonStepResult;
+
+char json_stream_container(JsonStream* stream) {
+    return stream->containers.data[stream->containers.count - 1];
+}
+
+// Moves on after a complete value
+void json_stream_value_done(JsonStream* stream) {
+    stream->state = stream->containers.count == 0 ? JSON_STREAM_DONE : JSON_STREAM_COMMA_OR_END;
+}
+
+JsonStepResult json_stream_open(JsonStream* stream, const JsonSax* sax, void* user, char c) {
+    if (stream->containers.count >= JSON_MAX_DEPTH) return JSON_STEP_ERROR;
+    bool ok = c == '['
+        ? JSON_SAX_EMIT(sax, on_array_begin, user)
+        : JSON_SAX_EMIT(sax, on_object_begin, user);
+    if (!ok) return JSON_STEP_ERROR;
+
+    json_sb_push(&stream->containers, &c, 1);
+    stream->state = c == '[' ? JSON_STREAM_VALUE_OR_END : JSON_STREAM_KEY_OR_END;
+    return JSON_STEP_OK;
+}
+
+JsonStepResult json_stream_close(JsonStream* stream, const JsonSax* sax, void* user) {
+    char c = stream->containers.data[--stream->containers.count];
+    bool ok = c == '['
+        ? JSON_SAX_EMIT(sax, on_array_end, user)
+        : JSON_SAX_EMIT(sax, on_object_end, user);
+    if (!ok) return JSON_STEP_ERROR;
+
+    json_stream_value_done(stream);
+    return JSON_STEP_OK;
+}
+
+// Reads one string token. The cursor must be on the opening quote.
+JsonStepResult json_stream_string(JsonStream* stream, JsonLexer* lexer, bool final, AliSv* out) {
+    const char* start = ++lexer->cursor;
+    json_lexer_skip_string_body(lexer);
+    if (json_is_empty(lexer)) return final ? JSON_STEP_ERROR : JSON_STEP_MORE;
+
+    lexer->cursor = start;
+    return json_lexer_read_string(lexer, &stream->unescaped, out) ? JSON_STEP_OK : JSON_STEP_ERROR;
+}
+
+JsonStepResult json_stream_scalar(JsonStream* stream, JsonLexer* lexer, bool final, const JsonSax* sax, void* user) {
+    const char* end = json_lexer_end(lexer);
+    char c = *lexer->cursor;
+
+    if (c == '"') {
+        AliSv string;
+        JsonStepResult result = json_stream_string(stream, lexer, final, &string);
+        if (result != JSON_STEP_OK) return result;
+        return JSON_SAX_EMIT(sax, on_string, user, string.start, string.len) ? JSON_STEP_OK : JSON_STEP_ERROR;
+    }
+
+    if (c == '-' || json_is_digit(c)) {
+        JsonNumber number;
+        const char* number_end;
+        if (!json_parse_number(lexer->cursor, end, &number, &number_end)) {
+            return final || number_end < end ? JSON_STEP_ERROR : JSON_STEP_MORE;
+        }
+        // More digits could follow in the next chunk
+        if (number_end == end && !final) return JSON_STEP_MORE;
+        lexer->cursor = number_end;
+        return json_sax_emit_number(sax, user, &number) ? JSON_STEP_OK : JSON_STEP_ERROR;
+    }
+
+    bool partial;
+    size_t len = json_literal_len(lexer->cursor, end, &partial);
+    if (partial) return final ? JSON_STEP_ERROR : JSON_STEP_MORE;
+    if (len == 0) return JSON_STEP_ERROR;
+    lexer->cursor += len;
+    bool ok = c == 'n'
+        ? JSON_SAX_EMIT(sax, on_null, user)
+        : JSON_SAX_EMIT(sax, on_boolean, user, c == 't');
+    return ok ? JSON_STEP_OK : JSON_STEP_ERROR;
+}
+
+// Consumes one token from the lexer and advances the grammar state.
+JsonStepResult json_stream_step(JsonStream* stream, JsonLexer* lexer, bool final) {
+    json_lexer_trim_left(lexer);
+    if (json_is_empty(lexer)) return JSON_STEP_MORE;
+
+    void* user;
+    const JsonSax* sax = json_stream_sax_target(stream, &user);
+    char c = *lexer->cursor;
+    switch (stream->state) {
+        case JSON_STREAM_VALUE_OR_END:
+            if (c == ']') {
+                lexer->cursor++;
+                return json_stream_close(stream, sax, user);
+            }
+            // fallthrough
+        case JSON_STREAM_VALUE: {
+            if (c == '[' || c == '{') {
+                lexer->cursor++;
+                return json_stream_open(stream, sax, user, c);
+            }
+
+            JsonStepResult result = json_stream_scalar(stream, lexer, final, sax, user);
+            if (result == JSON_STEP_OK) json_stream_value_done(stream);
+            return result;
+        }
+        case JSON_STREAM_KEY_OR_END:
+            if (c == '}') {
+                lexer->cursor++;
+                return json_stream_close(stream, sax, user);
+            }
+            // fallthrough
+        case JSON_STREAM_KEY: {
+            if (c != '"') return JSON_STEP_ERROR;
+            AliSv key;
+            JsonStepResult result = json_stream_string(stream, lexer, final, &key);
+            if (result != JSON_STEP_OK) return result;
+            if (!JSON_SAX_EMIT(sax, on_key, user, key.start, key.len)) return JSON_STEP_ERROR;
+            stream->state = JSON_STREAM_COLON;
+            return JSON_STEP_OK;
+        }
+        case JSON_STREAM_COLON:
+            if (c != ':') return JSON_STEP_ERROR;
+            lexer->cursor++;
+            stream->state = JSON_STREAM_VALUE;
+            return JSON_STEP_OK;
+        case JSON_STREAM_COMMA_OR_END: {
+            char open = json_stream_container(stream);
+            if (c == ',') {
+                lexer->cursor++;
+                stream->state = open == '[' ? JSON_STREAM_VALUE : JSON_STREAM_KEY;
+                return JSON_STEP_OK;
+            }
+            if ((c == ']' && open == '[') || (c == '}' && open == '{')) {
+                lexer->cursor++;
+                return json_stream_close(stream, sax, user);
+            }
+            return JSON_STEP_ERROR;
+        }
+        case JSON_STREAM_DONE:
+        case JSON_STREAM_FAILED:
+            return JSON_STEP_ERROR;
+    }
+    return JSON_STEP_ERROR;
+}
+
+// Runs all complete tokens of `lexer`. Returns false on a syntax error,
+// otherwise leaves the cursor at the start of an unfinished token.
+bool json_stream_run(JsonStream* stream, JsonLexer* lexer, bool final) {
+    for (;;) {
+        const char* token_start = lexer->cursor;
+        switch (json_stream_step(stream, lexer, final)) {
+            case JSON_STEP_OK: break;
+            case JSON_STEP_MORE:
+                lexer->cursor = json_skip_whitespace(token_start, json_lexer_end(lexer));
+                return true;
+            case JSON_STEP_ERROR:
+                stream->state = JSON_STREAM_FAILED;
+                return false;
+        }
+    }
+}
+
+// How many bytes of `chunk` belong to the token buffered in the carry,
+// or chunk_size + 1 if the token doesn't end in this chunk yet.
+size_t json_stream_carry_rest(JsonStream* stream, const char* chunk, size_t chunk_size) {
+    const char* p = chunk;
+    const char* end = chunk + chunk_size;
+
+    if (stream->carry.data[0] == '"') {
+        size_t backslashes = 0;
+        for (size_t i = stream->carry.count; i > 1 && stream->carry.data[i - 1] == '\\'; --i) backslashes++;
+        if (backslashes % 2 == 1) p++;
+
+        while (p < end) {
+            p = json_scan_string(p, end);
+            if (p >= end) break;
+            if (*p == '"') return p + 1 - chunk;
+            p += 2;
+        }
+        return chunk_size + 1;
+    }
+
+    while (p < end && (isalnum((unsigned char)*p) || *p == '-' || *p == '+' || *p == '.')) p++;
+    return p < end ? (size_t)(p - chunk) : chunk_size + 1;
+}
+
+bool json_stream_feed(JsonStream* stream, const char* chunk, size_t chunk_size) {
+    if (stream->state == JSON_STREAM_FAILED) return false;
+
+    if (stream->carry.count > 0) {
+        size_t rest = json_stream_carry_rest(stream, chunk, chunk_size);
+        if (rest > chunk_size) {
+            json_sb_push(&stream->carry, chunk, chunk_size);
+            return true;
+        }
+
+        json_sb_push(&stream->carry, chunk, rest);
+        JsonLexer lexer = json_lexer(stream->carry.data, stream->carry.count);
+        if (json_stream_step(stream, &lexer, true) != JSON_STEP_OK || !json_is_empty(&lexer)) {
+            stream->state = JSON_STREAM_FAILED;
+            return false;
+        }
+        stream->carry.count = 0;
+        chunk += rest;
+        chunk_size -= rest;
+    }
+
+    JsonLexer lexer = json_lexer(chunk, chunk_size);
+    if (!json_stream_run(stream, &lexer, false)) return false;
+    json_sb_push(&stream->carry, lexer.cursor, json_lexer_end(&lexer) - lexer.cursor);
+    return true;
+}
+
+bool json_stream_finish(JsonStream* stream, JsonValue* value) {
+    if (stream->state == JSON_STREAM_FAILED) return false;
+
+    if (stream->carry.count > 0) {
+        JsonLexer lexer = json_lexer(stream->carry.data, stream->carry.count);
+        if (!json_stream_run(stream, &lexer, true)) return false;
+        stream->carry.count = 0;
+    }
+
+    if (stream->state != JSON_STREAM_DONE) {
+        stream->state = JSON_STREAM_FAILED;
+        return false;
+    }
+    if (value != NULL && stream->sax == NULL) *value = stream->builder.root;
+    return true;
+}
+
+// NDJSON
+
+#ifndef JSON_NDJSON_BATCH_SIZE
+#define JSON_NDJSON_BATCH_SIZE (1024*1024)
+#endif // JSON_NDJSON_BATCH_SIZE
+
+typedef struct {
+    size_t line; // relative to the start of the batch
+    JsonValue value;
+}JsonRecord;
+
+typedef struct {
+    const char* start;
+    const char* end;
+    unsigned flags;
+
+    AliArena arena;
+    AliSb records;
+    size_t lines;
+    bool ok;
+    JsonError error; // offset from `start`
+
+#ifdef JSON_HAVE_THREADS
+    pthread_t worker;
+    bool started;
+#endif // JSON_HAVE_THREADS
+}JsonNdjsonBatch;
+
+JsonNdjson json_ndjson(const char* content_start, size_t content_size) {
+    JsonNdjson ndjson = {0};
+    ndjson.content_start = content_start;
+    ndjson.content_len = content_size;
+    return ndjson;
+}
+
+void json_ndjson_batch_parse(JsonNdjsonBatch* batch) {
+    batch->records.count = 0;
+    batch->lines = 0;
+    batch->ok = true;
+
+    // One lexer per batch keeps its scratch stack warm across records
+    JsonLexer lexer = json_lexer_with_arena(batch->start, 0, &batch->arena);
+    lexer.flags = batch->flags;
+
+    // The batch ends right before a newline or at the end of the input
+    for (const char* p = batch->start; ; p++) {
+        const char* line_end = json_scan_newline(p, batch->end);
+        lexer.content_start = p;
+        lexer.content_len = line_end - p;
+        lexer.cursor = p;
+        batch->lines++;
+        p = line_end;
+
+        json_lexer_trim_left(&lexer);
+        if (json_is_empty(&lexer)) {
+            if (p == batch->end) break;
+            continue;
+        }
+
+        JsonRecord record = { batch->lines - 1, {0} };
+        bool ok = json_lexer_parse_value(&lexer, &record.value);
+        if (ok) {
+            json_lexer_trim_left(&lexer);
+            ok = json_is_empty(&lexer) || json_lexer_fail(&lexer, JSON_ERROR_UNEXPECTED_CHAR, 0);
+        }
+        if (!ok) {
+            batch->ok = false;
+            batch->error = lexer.error;
+            batch->error.offset += lexer.content_start - batch->start;
+            break;
+        }
+        json_scratch_push(&batch->records, &record, sizeof(record));
+        if (p == batch->end) break;
+    }
+
+    json_lexer_free(&lexer);
+}
+
+#ifdef JSON_HAVE_THREADS
+void* json_ndjson_worker(void* arg) {
+    json_ndjson_batch_parse(arg);
+    return NULL;
+}
+#endif // JSON_HAVE_THREADS
+
+bool json_ndjson_parse(JsonNdjson* ndjson, JsonRecordFn fn, void* user) {
+    size_t threads = ndjson->threads > 0 ? ndjson->threads : 1;
+#ifndef JSON_HAVE_THREADS
+    threads = 1;
+#endif // JSON_HAVE_THREADS
+    size_t batch_size = ndjson->batch_size > 0 ? ndjson->batch_size : JSON_NDJSON_BATCH_SIZE;
+
+    JsonNdjsonBatch* batches = ALI_MALLOC(threads * sizeof(*batches));
+    memset(batches, 0, threads * sizeof(*batches));
+
+    const char* p = ndjson->content_start;
+    const char* end = p + ndjson->content_len;
+    size_t line = 0;
+    bool ok = true;
+    ndjson->error_line = 0;
+    ndjson->error = (JsonError) {0};
+
+    while (ok && p < end) {
+        // Cut the next round of batches at line boundaries
+        size_t count = 0;
+        while (count < threads && p < end) {
+            JsonNdjsonBatch* batch = &batches[count++];
+            const char* cut = (size_t)(end - p) > batch_size ? p + batch_size : end;
+            cut = json_scan_newline(cut, end);
+            batch->start = p;
+            batch->end = cut;
+            batch->flags = ndjson->flags;
+            p = cut < end ? cut + 1 : end;
+        }
+
+#ifdef JSON_HAVE_THREADS
+        // The calling thread takes the first batch of the round
+        for (size_t i = 1; i < count; ++i) {
+            JsonNdjsonBatch* batch = &batches[i];
+            batch->started = pthread_create(&batch->worker, NULL, json_ndjson_worker, batch) == 0;
+            if (!batch->started) json_ndjson_batch_parse(batch);
+        }
+        json_ndjson_batch_parse(&batches[0]);
+        for (size_t i = 1; i < count; ++i) {
+            if (batches[i].started) pthread_join(batches[i].worker, NULL);
+        }
+#else
+        json_ndjson_batch_parse(&batches[0]);
+#endif // JSON_HAVE_THREADS
+
+        for (size_t i = 0; i < count && ok; ++i) {
+            JsonNdjsonBatch* batch = &batches[i];
+            JsonRecord* records = (JsonRecord*)batch->records.data;
+            size_t records_count = batch->records.count / sizeof(*records);
+            for (size_t j = 0; j < records_count && ok; ++j) {
+                ok = fn(user, line + records[j].line + 1, &records[j].value);
+            }
+            if (!ok) {
+                ndjson->error.code = JSON_ERROR_CALLBACK;
+            } else if (!batch->ok) {
+                ndjson->error_line = line + batch->lines;
+                ndjson->error = batch->error;
+                ndjson->error.offset += batch->start - ndjson->content_start;
+                ok = false;
+            }
+            line += batch->lines;
+        }
+
+        for (size_t i = 0; i < count; ++i) ali_arena_reset(&batches[i].arena);
+    }
+
+    for (size_t i = 0; i < threads; ++i) {
+        ali_arena_free(&batches[i].arena);
+        ali_sb_free(&batches[i].records);
+    }
+    ALI_FREE(batches);
+    return ok;
+}
+
+// Parallel arrays
+
+#ifndef JSON_PARALLEL_MIN_SIZE
+#define JSON_PARALLEL_MIN_SIZE (1024*1024)
+#endif // JSON_PARALLEL_MIN_SIZE
+
+// Steps over the string body at `p`, returns the end of the closing quote
+// or NULL if the input ends first.
+const char* json_skip_string(const char* p, const char* end) {
+    for (;;) {
+        p = json_scan_string(p, end);
+        if (p >= end) return NULL;
+        if (*p == '"') return p + 1;
+        p += 2;
+    }
+}
+
+// Finds the end of the value at `p` by matching quotes and brackets only.
+// Returns NULL if the input ends first. The value itself is not checked.
+const char* json_skip_value(const char* p, const char* end) {
+    if (p >= end) return NULL;
+    if (*p == '"') return json_skip_string(p + 1, end);
+
+    if (*p != '[' && *p != '{') {
+        while (p < end && *p != ',' && *p != ']' && *p != '}' && !json_is_whitespace(*p)) p++;
+        return p;
+    }
+
+    // Classifies whole blocks at once and only stops at the bytes that
+    // matter, strings are tracked so that brackets in them are ignored.
+    size_t depth = 0;
+    bool in_string = false;
+    bool escaped = false;
+    while (p < end) {
+        size_t n = end - p < JSON_SCAN_BLOCK ? (size_t)(end - p) : JSON_SCAN_BLOCK;
+        uint64_t quotes = 0, backslashes = 0, opens = 0, closes = 0;
+        if (n == JSON_SCAN_BLOCK) {
+            quotes = json_block_eq(p, '"', '"', '"', '"');
+            backslashes = json_block_eq(p, '\\', '\\', '\\', '\\');
+            opens = json_block_eq(p, '[', '{', '[', '{');
+            closes = json_block_eq(p, ']', '}', ']', '}');
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t bit = 1ull << i;
+                if (p[i] == '"') quotes |= bit;
+                else if (p[i] == '\\') backslashes |= bit;
+                else if (p[i] == '[' || p[i] == '{') opens |= bit;
+                else if (p[i] == ']' || p[i] == '}') closes |= bit;
+            }
+        }
+
+        uint64_t bits = quotes | backslashes | opens | closes;
+        if (escaped) bits &= ~1ull;
+        escaped = false;
+        while (bits != 0) {
+            int i = __builtin_ctzll(bits);
+            uint64_t bit = 1ull << i;
+            bits &= bits - 1;
+
+            if (in_string) {
+                if (backslashes & bit) {
+                    if (i == JSON_SCAN_BLOCK - 1) escaped = true;
+                    else bits &= ~(bit << 1);
+                } else if (quotes & bit) {
+                    in_string = false;
+                }
+            } else if (quotes & bit) {
+                in_string = true;
+            } else if (opens & bit) {
+                depth++;
+            } else if ((closes & bit) && --depth == 0) {
+                return p + i + 1;
+            }
+        }
+        p += n;
+    }
+    return NULL;
+}
+
+typedef struct {
+    const char* start;
+    const char* end;
+}JsonSpan;
+
+typedef struct {
+    const char* content_start;
+    const char* content_end;
+    const JsonSpan* spans;
+    size_t count;
+    unsigned flags;
+    size_t max_depth; // what is left of the lexer's for each element
+
+    AliArena arena;
+    AliSb values;
+    bool ok;
+    JsonError error; // offset from `content_start`
+
+#ifdef JSON_HAVE_THREADS
+    pthread_t worker;
+    bool started;
+#endif // JSON_HAVE_THREADS
+}JsonParallelRange;
+
+void json_parallel_range_parse(JsonParallelRange* range) {
+    JsonLexer lexer = json_lexer_with_arena(range->content_start, range->content_end - range->content_start, &range->arena);
+    lexer.flags = range->flags;
+    lexer.max_depth = range->max_depth;
+    range->ok = true;
+
+    for (size_t i = 0; i < range->count; ++i) {
+        JsonValue value;
+        lexer.cursor = range->spans[i].start;
+        bool ok = json_lexer_parse_value(&lexer, &value);
+        if (ok && lexer.cursor != range->spans[i].end) ok = json_lexer_fail(&lexer, JSON_ERROR_UNEXPECTED_CHAR, 0);
+        if (!ok) {
+            range->ok = false;
+            range->error = lexer.error;
+            break;
+        }
+        json_scratch_push(&range->values, &value, sizeof(value));
+    }
+
+    json_lexer_free(&lexer);
+}
+
+#ifdef JSON_HAVE_THREADS
+void* json_parallel_worker(void* arg) {
+    json_parallel_range_parse(arg);
+    return NULL;
+}
+#endif // JSON_HAVE_THREADS
+
+// Moves every region of `src` into `dst`, so the tree built in `src`
+// lives as long as `dst`.
+void json_arena_splice(AliArena* dst, AliArena* src) {
+    if (src->start == NULL) return;
+    if (dst->start == NULL) {
+        *dst = *src;
+    } else {
+        AliRegion* last = src->start;
+        while (last->next != NULL) last = last->next;
+        last->next = dst->end->next;
+        dst->end->next = src->start;
+        dst->end = src->end;
+    }
+    *src = (AliArena) {0};
+}
+
+size_t json_lexer_depth_limit(JsonLexer* lexer) {
+    return lexer->max_depth > 0 ? lexer->max_depth : JSON_MAX_DEPTH;
+}
+
+// json_lexer_parse_value for a value inside `depth` open containers, which
+// count against the lexer's max_depth. `depth` must be below it.
+bool json_parallel_parse_serial(JsonLexer* lexer, JsonValue* value, size_t depth) {
+    size_t max_depth = lexer->max_depth;
+    lexer->max_depth = json_lexer_depth_limit(lexer) - depth;
+    bool ok = json_lexer_parse_value(lexer, value);
+    lexer->max_depth = max_depth;
+    return ok;
+}
+
+// Points the keys and short strings of a tree built by a worker at the
+// copies in `intern`, which the worker's own table didn't know. Strings
+// that are new to it stay where the worker put them.
+void json_parallel_reintern(JsonIntern* intern, JsonValue* value) {
+    switch (value->type) {
+        case JSON_STRING:
+            if (!json_value_is_inline(value) && value->as.string.len <= JSON_INTERN_MAX_LEN) {
+                value->as.string = json_intern(intern, NULL, value->as.string.start, value->as.string.len);
+            }
+            break;
+        case JSON_ARRAY:
+            for (size_t i = 0; i < value->as.array.len; ++i) json_parallel_reintern(intern, &value->as.array.items[i]);
+            break;
+        case JSON_OBJECT:
+            for (size_t i = 0; i < value->as.object.len; ++i) {
+                JsonObjectItem* item = &value->as.object.items[i];
+                item->key = json_intern(intern, NULL, item->key.start, item->key.len);
+                json_parallel_reintern(intern, &item->value);
+            }
+            break;
+        case JSON_NUMBER:
+        case JSON_INTEGER:
+        case JSON_BOOLEAN:
+        case JSON_NULL:
+            break;
+    }
+}
+
+// The cursor must be on the '[', inside `depth` open containers. Finds the
+// element boundaries first, then parses ranges of elements on their own
+// threads.
+bool json_parallel_array(JsonLexer* lexer, JsonValue* value, size_t threads, size_t depth) {
+    const char* start = lexer->cursor;
+    const char* end = json_lexer_end(lexer);
+
+    AliSb spans = {0};
+    const char* p = json_skip_whitespace(start + 1, end);
+    bool ok = true;
+    if (p < end && *p == ']') {
+        p++;
+    } else {
+        for (;;) {
+            JsonSpan span = { p, json_skip_value(p, end) };
+            if (span.end == NULL || span.end == span.start) {
+                ok = false;
+                break;
+            }
+            json_scratch_push(&spans, &span, sizeof(span));
+
+            p = json_skip_whitespace(span.end, end);
+            if (p < end && *p == ',') {
+                p = json_skip_whitespace(p + 1, end);
+                continue;
+            }
+            if (p < end && *p == ']') p++;
+            else ok = false;
+            break;
+        }
+    }
+
+    // Elements start one deeper than the array, and a lexer can't be
+    // limited to no containers at all
+    size_t element_depth = json_lexer_depth_limit(lexer) - depth - 1;
+    size_t count = spans.count / sizeof(JsonSpan);
+    if (!ok || (size_t)(p - start) < JSON_PARALLEL_MIN_SIZE || count < 2 || threads < 2 || element_depth == 0) {
+        ali_sb_free(&spans);
+        return json_parallel_parse_serial(lexer, value, depth);
+    }
+    if (threads > count) threads = count;
+
+    JsonParallelRange* ranges = ALI_MALLOC(threads * sizeof(*ranges));
+    memset(ranges, 0, threads * sizeof(*ranges));
+    size_t first = 0;
+    for (size_t i = 0; i < threads; ++i) {
+        size_t n = count / threads + (i < count % threads);
+        ranges[i].content_start = start;
+        ranges[i].content_end = p;
+        ranges[i].spans = (JsonSpan*)spans.data + first;
+        ranges[i].count = n;
+        ranges[i].flags = lexer->flags;
+        ranges[i].max_depth = element_depth;
+        first += n;
+    }
+
+#ifdef JSON_HAVE_THREADS
+    // The calling thread takes the first range
+    for (size_t i = 1; i < threads; ++i) {
+        JsonParallelRange* range = &ranges[i];
+        range->started = pthread_create(&range->worker, NULL, json_parallel_worker, range) == 0;
+        if (!range->started) json_parallel_range_parse(range);
+    }
+    json_parallel_range_parse(&ranges[0]);
+    for (size_t i = 1; i < threads; ++i) {
+        if (ranges[i].started) pthread_join(ranges[i].worker, NULL);
+    }
+#else
+    for (size_t i = 0; i < threads; ++i) json_parallel_range_parse(&ranges[i]);
+#endif // JSON_HAVE_THREADS
+
+    AliArena* arena = json_lexer_arena(lexer);
+    for (size_t i = 0; i < threads && ok; ++i) {
+        if (ranges[i].ok) continue;
+        lexer->error = ranges[i].error;
+        lexer->error.offset += start - lexer->content_start;
+        ok = false;
+    }
+    if (ok) {
+        // Stitch the ranges together, the children stay where they were built
+        JsonValue* items = json_alloc(arena, count * sizeof(JsonValue));
+        size_t offset = 0;
+        for (size_t i = 0; i < threads; ++i) {
+            memcpy(items + offset, ranges[i].values.data, ranges[i].values.count);
+            offset += ranges[i].count;
+        }
+        *value = json_value_array();
+        value->as.array = (JsonArray) { count, count, items };
+        lexer->cursor = p;
+
+        // The workers interned into tables of their own
+        if (lexer->flags & JSON_PARSE_INTERN) json_parallel_reintern(&lexer->intern, value);
+    }
+
+    for (size_t i = 0; i < threads; ++i) {
+        if (ok) json_arena_splice(arena, &ranges[i].arena);
+        ali_arena_free(&ranges[i].arena);
+        ali_sb_free(&ranges[i].values);
+    }
+    ALI_FREE(ranges);
+    ali_sb_free(&spans);
+    return ok;
+}
+
+// Walks objects itself so that large arrays below them are found too.
+// `depth` counts the objects around the value, everything below them is
+// parsed with what is left of the lexer's max_depth.
+bool json_parallel_value(JsonLexer* lexer, JsonValue* value, size_t threads, size_t depth) {
+    json_lexer_trim_left(lexer);
+    if (json_is_empty(lexer)) return json_lexer_parse_value(lexer, value);
+    if (*lexer->cursor != '[' && *lexer->cursor != '{') return json_lexer_parse_value(lexer, value);
+    if (depth >= json_lexer_depth_limit(lexer)) return json_lexer_fail(lexer, JSON_ERROR_DEPTH, 0);
+    if (*lexer->cursor == '[') return json_parallel_array(lexer, value, threads, depth);
+
+    lexer->cursor++;
+    json_lexer_trim_left(lexer);
+
+    AliArena* arena = json_lexer_arena(lexer);
+    AliSb items = {0};
+    if (!json_is_empty(lexer) && *lexer->cursor == '}') {
+        lexer->cursor++;
+    } else {
+        for (;;) {
+            json_lexer_trim_left(lexer);
+            if (!json_lexer_expect_char(lexer, '"')) goto fail;
+            AliSv key;
+            if (!json_lexer_read_string(lexer, &lexer->unescaped, &key)) goto fail;
+
+            JsonObjectItem item;
+            JsonDomBuilder builder = json_lexer_dom_builder(lexer);
+            item.key = json_dom_string(&builder, key.start, key.len, true);
+
+            json_lexer_trim_left(lexer);
+            if (!json_lexer_expect_char(lexer, ':')) goto fail;
+            if (!json_parallel_value(lexer, &item.value, threads, depth + 1)) goto fail;
+            json_scratch_push(&items, &item, sizeof(item));
+
+            json_lexer_trim_left(lexer);
+            if (json_is_empty(lexer) || *lexer->cursor != ',') break;
+            lexer->cursor++;
+        }
+        if (!json_lexer_expect_char(lexer, '}')) goto fail;
+    }
+
+    *value = json_commit_object(&items, arena, 0);
+    ali_sb_free(&items);
+    return true;
+
+fail:
+    ali_sb_free(&items);
+    return false;
+}
+
+bool json_lexer_parse_parallel(JsonLexer* lexer, JsonValue* value, size_t threads) {
+#ifndef JSON_HAVE_THREADS
+    threads = 1;
+#endif // JSON_HAVE_THREADS
+    if (threads < 2) return json_lexer_parse_value(lexer, value);
+    return json_parallel_value(lexer, value, threads, 0);
+}
+
+// Tape
+
+#define JSON_TAPE_NUMBER 'd'
+#define JSON_TAPE_INTEGER 'i'
+#define JSON_TAPE_TRUE 't'
+#define JSON_TAPE_FALSE 'f'
+#define JSON_TAPE_NULL 'n'
+#define JSON_TAPE_STRING '"'
+#define JSON_TAPE_ARRAY_BEGIN '['
+#define JSON_TAPE_ARRAY_END ']'
+#define JSON_TAPE_OBJECT_BEGIN '{'
+#define JSON_TAPE_OBJECT_END '}'
+
+#define JSON_TAPE_PAYLOAD_MASK ((1ull << 56) - 1)
+
+typedef struct {
+    size_t open; // word index of the container
+    size_t count;
+}JsonTapeFrame;
+
+typedef struct {
+    AliSb words;
+    AliSb strings;
+    AliSb frames;
+}JsonTapeBuilder;
+
+uint64_t json_tape_word(char tag, uint64_t payload) {
+    return (uint64_t)(unsigned char)tag << 56 | payload;
+}
+
+char json_tape_tag(uint64_t word) {
+    return (char)(word >> 56);
+}
+
+uint64_t json_tape_payload(uint64_t word) {
+    return word & JSON_TAPE_PAYLOAD_MASK;
+}
+
+size_t json_tape_push(JsonTapeBuilder* builder, char tag, uint64_t payload) {
+    uint64_t word = json_tape_word(tag, payload);
+    return json_scratch_push(&builder->words, &word, sizeof(word)) / sizeof(word) - 1;
+}
+
+// Counts a value towards its container
+void json_tape_count(JsonTapeBuilder* builder) {
+    if (builder->frames.count == 0) return;
+    JsonTapeFrame* top = (JsonTapeFrame*)(builder->frames.data + builder->frames.count) - 1;
+    top->count++;
+}
+
+bool json_tape_push_string(JsonTapeBuilder* builder, const char* string, size_t len) {
+    uint64_t len64 = len;
+    json_tape_push(builder, JSON_TAPE_STRING, builder->strings.count);
+    json_scratch_push(&builder->strings, &len64, sizeof(len64));
+    json_scratch_push(&builder->strings, string, len);
+    json_scratch_push(&builder->strings, "", 1);
+    return true;
+}
+
+bool json_tape_open(JsonTapeBuilder* builder, char tag) {
+    json_tape_count(builder);
+    JsonTapeFrame frame = { json_tape_push(builder, tag, 0), 0 };
+    json_scratch_push(&builder->frames, &frame, sizeof(frame));
+    return true;
+}
+
+bool json_tape_close(JsonTapeBuilder* builder, char tag) {
+    builder->frames.count -= sizeof(JsonTapeFrame);
+    JsonTapeFrame frame = *(JsonTapeFrame*)(builder->frames.data + builder->frames.count);
+
+    size_t close = json_tape_push(builder, tag, frame.count);
+    uint64_t* words = (uint64_t*)builder->words.data;
+    words[frame.open] |= close + 1;
+    return true;
+}
+
+bool json_tape_on_object_begin(void* user) {
+    return json_tape_open(user, JSON_TAPE_OBJECT_BEGIN);
+}
+
+bool json_tape_on_object_end(void* user) {
+    return json_tape_close(user, JSON_TAPE_OBJECT_END);
+}
+
+bool json_tape_on_array_begin(void* user) {
+    return json_tape_open(user, JSON_TAPE_ARRAY_BEGIN);
+}
+
+bool json_tape_on_array_end(void* user) {
+    return json_tape_close(user, JSON_TAPE_ARRAY_END);
+}
+
+bool json_tape_on_key(void* user, const char* key, size_t len) {
+    return json_tape_push_string(user, key, len);
+}
+
+bool json_tape_on_string(void* user, const char* string, size_t len) {
+    json_tape_count(user);
+    return json_tape_push_string(user, string, len);
+}
+
+bool json_tape_push_bits(JsonTapeBuilder* builder, char tag, const void* bits) {
+    json_tape_count(builder);
+    json_tape_push(builder, tag, 0);
+    json_scratch_push(&builder->words, bits, sizeof(uint64_t));
+    return true;
+}
+
+bool json_tape_on_number(void* user, double number) {
+    return json_tape_push_bits(user, JSON_TAPE_NUMBER, &number);
+}
+
+bool json_tape_on_integer(void* user, int64_t integer) {
+    return json_tape_push_bits(user, JSON_TAPE_INTEGER, &integer);
+}
+
+bool json_tape_on_boolean(void* user, bool boolean) {
+    json_tape_count(user);
+    json_tape_push(user, boolean ? JSON_TAPE_TRUE : JSON_TAPE_FALSE, 0);
+    return true;
+}
+
+bool json_tape_on_null(void* user) {
+    json_tape_count(user);
+    json_tape_push(user, JSON_TAPE_NULL, 0);
+    return true;
+}
+
+const JsonSax json_tape_sax = {
+    .on_object_begin = json_tape_on_object_begin,
+    .on_object_end = json_tape_on_object_end,
+    .on_array_begin = json_tape_on_array_begin,
+    .on_array_end = json_tape_on_array_end,
+    .on_key = json_tape_on_key,
+    .on_string = json_tape_on_string,
+    .on_number = json_tape_on_number,
+#if JSON_INTEGERS
+    .on_integer = json_tape_on_integer,
+#endif // JSON_INTEGERS
+    .on_boolean = json_tape_on_boolean,
+    .on_null = json_tape_on_null,
+};
+
+bool json_lexer_parse_tape(JsonLexer* lexer, JsonTape* tape) {
+    JsonTapeBuilder builder = {0};
+    bool ok = json_lexer_parse_sax(lexer, &json_tape_sax, &builder);
+    if (ok) {
+        AliArena* arena = json_lexer_arena(lexer);
+        tape->len = builder.words.count / sizeof(uint64_t);
+        tape->strings_len = builder.strings.count;
+        tape->words = json_scratch_commit(&builder.words, arena, 0);
+        tape->strings = json_scratch_commit(&builder.strings, arena, 0);
+    }
+
+    ali_sb_free(&builder.words);
+    ali_sb_free(&builder.strings);
+    ali_sb_free(&builder.frames);
+    return ok;
+}
+
+JsonTapeRef json_tape_root(const JsonTape* tape) {
+    JsonTapeRef ref = { tape->len > 0 ? tape : NULL, 0 };
+    return ref;
+}
+
+// An empty ref reads as word 0, which has none of the tags, so every
+// accessor treats it as no value
+uint64_t json_tape_at(JsonTapeRef ref) {
+    if (ref.tape == NULL) return 0;
+    return ref.tape->words[ref.index];
+}
+
+JsonValueType json_tape_type(JsonTapeRef ref) {
+    switch (json_tape_tag(json_tape_at(ref))) {
+        case JSON_TAPE_NUMBER: return JSON_NUMBER;
+        case JSON_TAPE_INTEGER: return JSON_INTEGER;
+        case JSON_TAPE_TRUE:
+        case JSON_TAPE_FALSE: return JSON_BOOLEAN;
+        case JSON_TAPE_NULL: return JSON_NULL;
+        case JSON_TAPE_STRING: return JSON_STRING;
+        case JSON_TAPE_ARRAY_BEGIN: return JSON_ARRAY;
+        case JSON_TAPE_OBJECT_BEGIN: return JSON_OBJECT;
+    }
+    return JSON_NULL;
+}
+
+bool json_tape_as_number(JsonTapeRef ref, double* number) {
+    if (json_tape_tag(json_tape_at(ref)) != JSON_TAPE_NUMBER) return false;
+    memcpy(number, &ref.tape->words[ref.index + 1], sizeof(*number));
+    return true;
+}
+
+bool json_tape_as_integer(JsonTapeRef ref, int64_t* integer) {
+    if (json_tape_tag(json_tape_at(ref)) != JSON_TAPE_INTEGER) return false;
+    memcpy(integer, &ref.tape->words[ref.index + 1], sizeof(*integer));
+    return true;
+}
+
+AliSv json_tape_as_sv(JsonTapeRef ref) {
+    uint64_t word = json_tape_at(ref);
+    if (json_tape_tag(word) != JSON_TAPE_STRING) return ali_sv_from_parts(NULL, 0);
+
+    const char* at = ref.tape->strings + json_tape_payload(word);
+    uint64_t len;
+    memcpy(&len, at, sizeof(len));
+    return ali_sv_from_parts((char*)at + sizeof(len), len);
+}
+
+bool json_tape_as_boolean(JsonTapeRef ref, bool* boolean) {
+    char tag = json_tape_tag(json_tape_at(ref));
+    if (tag != JSON_TAPE_TRUE && tag != JSON_TAPE_FALSE) return false;
+    *boolean = tag == JSON_TAPE_TRUE;
+    return true;
+}
+
+size_t json_tape_len(JsonTapeRef ref) {
+    uint64_t word = json_tape_at(ref);
+    char tag = json_tape_tag(word);
+    if (tag != JSON_TAPE_ARRAY_BEGIN && tag != JSON_TAPE_OBJECT_BEGIN) return 0;
+    return json_tape_payload(ref.tape->words[json_tape_payload(word) - 1]);
+}
+
+// Index of the word after the value at `index`
+size_t json_tape_skip(const JsonTape* tape, size_t index) {
+    uint64_t word = tape->words[index];
+    switch (json_tape_tag(word)) {
+        case JSON_TAPE_NUMBER:
+        case JSON_TAPE_INTEGER: return index + 2;
+        case JSON_TAPE_ARRAY_BEGIN:
+        case JSON_TAPE_OBJECT_BEGIN: return json_tape_payload(word);
+        default: return index + 1;
+    }
+}
+
+JsonTapeRef json_tape_valid(const JsonTape* tape, size_t index) {
+    char tag = json_tape_tag(tape->words[index]);
+    JsonTapeRef ref = { tag == JSON_TAPE_ARRAY_END || tag == JSON_TAPE_OBJECT_END ? NULL : tape, index };
+    return ref;
+}
+
+JsonTapeRef json_tape_first(JsonTapeRef ref) {
+    if (json_tape_len(ref) == 0) return (JsonTapeRef) {0};
+    return json_tape_valid(ref.tape, ref.index + 1);
+}
+
+JsonTapeRef json_tape_next(JsonTapeRef ref) {
+    if (ref.tape == NULL) return (JsonTapeRef) {0};
+    size_t next = json_tape_skip(ref.tape, ref.index);
+    if (next >= ref.tape->len) return (JsonTapeRef) {0};
+    return json_tape_valid(ref.tape, next);
+}
+
+JsonTapeRef json_tape_array_get_item(JsonTapeRef array, size_t index) {
+    if (json_tape_tag(json_tape_at(array)) != JSON_TAPE_ARRAY_BEGIN || index >= json_tape_len(array)) return (JsonTapeRef) {0};
+
+    JsonTapeRef item = json_tape_first(array);
+    while (index-- > 0) item = json_tape_next(item);
+    return item;
+}
+
+JsonTapeRef json_tape_object_find_value(JsonTapeRef object, char* key) {
+    if (json_tape_tag(json_tape_at(object)) != JSON_TAPE_OBJECT_BEGIN) return (JsonTapeRef) {0};
+
+    size_t len = strlen(key);
+    for (JsonTapeRef it = json_tape_first(object); it.tape != NULL; it = json_tape_next(json_tape_next(it))) {
+        AliSv item_key = json_tape_as_sv(it);
+        if (item_key.len == len && memcmp(item_key.start, key, len) == 0) return json_tape_next(it);
+    }
+    return (JsonTapeRef) {0};
+}
+
+// Cursor
+
+JsonCursor json_cursor(const char* content_start, size_t content_size) {
+    const char* end = content_start + content_size;
+    const char* start = json_skip_whitespace(content_start, end);
+    JsonCursor cursor = { start < end ? start : NULL, end };
+    return cursor;
+}
+
+JsonCursor json_cursor_at(JsonCursor cursor, const char* p) {
+    JsonCursor at = { p, cursor.end };
+    return at;
+}
+
+JsonValueType json_cursor_type(JsonCursor cursor) {
+    if (cursor.start == NULL) return JSON_NULL;
+    switch (*cursor.start) {
+        case '"': return JSON_STRING;
+        case '[': return JSON_ARRAY;
+        case '{': return JSON_OBJECT;
+        case 't':
+        case 'f': return JSON_BOOLEAN;
+        case 'n': return JSON_NULL;
+        default: return JSON_NUMBER;
+    }
+}
+
+bool json_cursor_as_number(JsonCursor cursor, double* number) {
+    JsonNumber parsed;
+    const char* number_end;
+    if (cursor.start == NULL || !json_parse_number(cursor.start, cursor.end, &parsed, &number_end)) return false;
+    *number = parsed.number;
+    return true;
+}
+
+AliSv json_cursor_as_sv(JsonCursor cursor) {
+    if (cursor.start == NULL || *cursor.start != '"') return ali_sv_from_parts(NULL, 0);
+    const char* end = json_skip_string(cursor.start + 1, cursor.end);
+    if (end == NULL) return ali_sv_from_parts(NULL, 0);
+    return ali_sv_from_parts((char*)cursor.start + 1, end - cursor.start - 2);
+}
+
+bool json_cursor_as_boolean(JsonCursor cursor, bool* boolean) {
+    if (cursor.start == NULL) return false;
+    size_t left = cursor.end - cursor.start;
+    if (left >= 4 && memcmp(cursor.start, "true", 4) == 0) {
+        *boolean = true;
+        return true;
+    }
+    if (left >= 5 && memcmp(cursor.start, "false", 5) == 0) {
+        *boolean = false;
+        return true;
+    }
+    return false;
+}
+
+JsonCursor json_cursor_first(JsonCursor cursor) {
+    if (cursor.start == NULL || (*cursor.start != '[' && *cursor.start != '{')) return (JsonCursor) {0};
+
+    const char* p = json_skip_whitespace(cursor.start + 1, cursor.end);
+    if (p >= cursor.end || *p == ']' || *p == '}') return (JsonCursor) {0};
+    return json_cursor_at(cursor, p);
+}
+
+JsonCursor json_cursor_next(JsonCursor cursor) {
+    if (cursor.start == NULL) return (JsonCursor) {0};
+    const char* p = json_skip_value(cursor.start, cursor.end);
+    if (p == NULL) return (JsonCursor) {0};
+
+    p = json_skip_whitespace(p, cursor.end);
+    if (p >= cursor.end || (*p != ',' && *p != ':')) return (JsonCursor) {0};
+
+    p = json_skip_whitespace(p + 1, cursor.end);
+    if (p >= cursor.end) return (JsonCursor) {0};
+    return json_cursor_at(cursor, p);
+}
+
+JsonCursor json_cursor_get_item(JsonCursor array, size_t index) {
+    if (array.start == NULL || *array.start != '[') return (JsonCursor) {0};
+
+    JsonCursor item = json_cursor_first(array);
+    while (item.start != NULL && index-- > 0) item = json_cursor_next(item);
+    return item;
+}
+
+JsonCursor json_cursor_find_value(JsonCursor object, char* key) {
+    if (object.start == NULL || *object.start != '{') return (JsonCursor) {0};
+
+    size_t len = strlen(key);
+    JsonCursor it = json_cursor_first(object);
+    while (it.start != NULL) {
+        AliSv item_key = json_cursor_as_sv(it);
+        if (item_key.start == NULL) break;
+
+        JsonCursor value = json_cursor_next(it);
+        if (item_key.len == len && memcmp(item_key.start, key, len) == 0) return value;
+        if (value.start == NULL) break;
+        it = json_cursor_next(value);
+    }
+    return (JsonCursor) {0};
+}
+
+bool json_cursor_parse(JsonCursor cursor, AliArena* arena, JsonValue* value) {
+    if (cursor.start == NULL || arena == NULL) return false;
+    JsonLexer lexer = json_lexer_with_arena(cursor.start, cursor.end - cursor.start, arena);
+    bool ok = json_lexer_parse_value(&lexer, value);
+    json_lexer_free(&lexer);
+    return ok;
+}
+
+// Paths
+
+JsonValue* json_object_find_hashed(JsonObject* object, const char* key, size_t len, uint32_t hash);
+
+// Works out everything a lookup needs ahead of time
+bool json_path_push_step(AliSb* steps, AliArena* arena, AliSb* key, bool wildcard) {
+    JsonPathStep step = {0};
+    step.key = json_strndup(arena, key->data, key->count);
+    step.key_len = key->count;
+    step.hash = json_hash_key(step.key, step.key_len);
+    step.wildcard = wildcard;
+
+    // Array indices are decimal without leading zeros
+    if (!wildcard && key->count > 0 && (key->data[0] != '0' || key->count == 1) && key->count <= 19) {
+        step.has_index = true;
+        for (size_t i = 0; i < key->count && step.has_index; ++i) {
+            if (!json_is_digit(key->data[i])) step.has_index = false;
+            else step.index = step.index * 10 + (key->data[i] - '0');
+        }
+    }
+
+    json_scratch_push(steps, &step, sizeof(step));
+    key->count = 0;
+    return true;
+}
+
+bool json_path_finish(AliSb* steps, AliSb* key, AliArena* arena, JsonPath* path, bool ok) {
+    if (ok) {
+        path->len = steps->count / sizeof(JsonPathStep);
+        path->steps = json_scratch_commit(steps, arena, 0);
+    }
+    ali_sb_free(steps);
+    ali_sb_free(key);
+    return ok;
+}
+
+bool json_path_compile_pointer(AliArena* arena, const char* pointer, JsonPath* path) {
+    AliSb steps = {0};
+    AliSb key = {0};
+
+    // The empty pointer is the whole document
+    if (*pointer != '\0' && *pointer != '/') return json_path_finish(&steps, &key, arena, path, false);
+
+    while (*pointer == '/') {
+        pointer++;
+        for (; *pointer != '\0' && *pointer != '/'; ++pointer) {
+            char c = *pointer;
+            if (c == '~') {
+                pointer++;
+                if (*pointer == '0') c = '~';
+                else if (*pointer == '1') c = '/';
+                else return json_path_finish(&steps, &key, arena, path, false);
+            }
+            json_sb_push(&key, &c, 1);
+        }
+        json_path_push_step(&steps, arena, &key, false);
+    }
+    return json_path_finish(&steps, &key, arena, path, true);
+}
+
+bool json_path_compile(AliArena* arena, const char* source, JsonPath* path) {
+    AliSb steps = {0};
+    AliSb key = {0};
+    const char* p = source;
+
+    if (*p == '$') p++;
+    if (*p == '.') p++;
+
+    while (*p != '\0') {
+        if (*p == '[') {
+            const char* close = strchr(p, ']');
+            if (close == NULL || close == p + 1) return json_path_finish(&steps, &key, arena, path, false);
+
+            bool wildcard = close == p + 2 && p[1] == '*';
+            if (!wildcard) {
+                for (const char* d = p + 1; d < close; ++d) {
+                    if (!json_is_digit(*d)) return json_path_finish(&steps, &key, arena, path, false);
+                }
+                json_sb_push(&key, p + 1, close - p - 1);
+            }
+            json_path_push_step(&steps, arena, &key, wildcard);
+            p = close + 1;
+        } else {
+            const char* end = p;
+            while (*end != '\0' && *end != '.' && *end != '[') end++;
+            if (end == p) return json_path_finish(&steps, &key, arena, path, false);
+
+            json_sb_push(&key, p, end - p);
+            json_path_push_step(&steps, arena, &key, end == p + 1 && *p == '*');
+            p = end;
+        }
+
+        if (*p == '.') {
+            p++;
+            if (*p == '\0') return json_path_finish(&steps, &key, arena, path, false);
+        } else if (*p != '\0' && *p != '[') {
+            return json_path_finish(&steps, &key, arena, path, false);
+        }
+    }
+    return json_path_finish(&steps, &key, arena, path, true);
+}
+
+JsonValue* json_path_step(JsonValue* value, const JsonPathStep* step) {
+    if (value->type == JSON_OBJECT) {
+        return json_object_find_hashed(&value->as.object, step->key, step->key_len, step->hash);
+    }
+    if (value->type == JSON_ARRAY && step->has_index) {
+        return json_array_get_item(&value->as.array, step->index);
+    }
+    return NULL;
+}
+
+// Returns false once `fn` asked to stop
+bool json_path_each_from(JsonValue* value, const JsonPathStep* step, const JsonPathStep* end, JsonPathFn fn, void* user) {
+    for (; step < end; ++step) {
+        if (!step->wildcard) {
+            value = json_path_step(value, step);
+            if (value == NULL) return true;
+            continue;
+        }
+
+        if (value->type == JSON_ARRAY) {
+            for (size_t i = 0; i < value->as.array.len; ++i) {
+                if (!json_path_each_from(&value->as.array.items[i], step + 1, end, fn, user)) return false;
+            }
+        } else if (value->type == JSON_OBJECT) {
+            for (size_t i = 0; i < value->as.object.len; ++i) {
+                if (!json_path_each_from(&value->as.object.items[i].value, step + 1, end, fn, user)) return false;
+            }
+        }
+        return true;
+    }
+    return fn(user, value);
+}
+
+bool json_path_first(void* user, JsonValue* value) {
+    *(JsonValue**)user = value;
+    return false;
+}
+
+JsonValue* json_path_find(JsonValue* root, const JsonPath* path) {
+    JsonValue* found = NULL;
+    json_path_each_from(root, path->steps, path->steps + path->len, json_path_first, &found);
+    return found;
+}
+
+void json_path_each(JsonValue* root, const JsonPath* path, JsonPathFn fn, void* user) {
+    json_path_each_from(root, path->steps, path->steps + path->len, fn, user);
+}
+
+JsonCursor json_path_cursor_step(JsonCursor cursor, const JsonPathStep* step) {
+    if (*cursor.start == '{') return json_cursor_find_value(cursor, step->key);
+    if (*cursor.start == '[' && step->has_index) return json_cursor_get_item(cursor, step->index);
+    return (JsonCursor) {0};
+}
+
+bool json_path_each_cursor_from(JsonCursor cursor, const JsonPathStep* step, const JsonPathStep* end, JsonPathCursorFn fn, void* user) {
+    for (; step < end; ++step) {
+        if (!step->wildcard) {
+            cursor = json_path_cursor_step(cursor, step);
+            if (cursor.start == NULL) return true;
+            continue;
+        }
+
+        if (*cursor.start != '[' && *cursor.start != '{') return true;
+        bool object = *cursor.start == '{';
+        for (JsonCursor it = json_cursor_first(cursor); it.start != NULL; it = json_cursor_next(it)) {
+            // Items of objects start with their key
+            if (object) {
+                it = json_cursor_next(it);
+                if (it.start == NULL) break;
+            }
+            if (!json_path_each_cursor_from(it, step + 1, end, fn, user)) return false;
+        }
+        return true;
+    }
+    return fn(user, cursor);
+}
+
+bool json_path_first_cursor(void* user, JsonCursor value) {
+    *(JsonCursor*)user = value;
+    return false;
+}
+
+JsonCursor json_path_find_cursor(JsonCursor root, const JsonPath* path) {
+    JsonCursor found = {0};
+    if (root.start == NULL) return found;
+    json_path_each_cursor_from(root, path->steps, path->steps + path->len, json_path_first_cursor, &found);
+    return found;
+}
+
+void json_path_each_cursor(JsonCursor root, const JsonPath* path, JsonPathCursorFn fn, void* user) {
+    if (root.start == NULL) return;
+    json_path_each_cursor_from(root, path->steps, path->steps + path->len, fn, user);
+}
+
+// Schemas
+
+JsonSchema json_schema(const JsonField* fields, size_t len) {
+    JsonSchema schema = {0};
+    schema.fields = fields;
+    schema.len = len;
+    return schema;
+}
+
+// Keys may hold NULs, so the name's length is compared before its bytes
+bool json_field_is(const JsonField* field, const char* key, size_t len) {
+    return strlen(field->name) == len && memcmp(field->name, key, len) == 0;
+}
+
+const JsonField* json_schema_field(JsonSchema* schema, size_t position, const char* key, size_t len) {
+    if (position < JSON_SCHEMA_SHAPE_MAX && schema->shape[position] != 0) {
+        const JsonField* cached = &schema->fields[schema->shape[position] - 1];
+        if (json_field_is(cached, key, len)) return cached;
+    }
+
+    for (size_t i = 0; i < schema->len; ++i) {
+        if (!json_field_is(&schema->fields[i], key, len)) continue;
+        if (position < JSON_SCHEMA_SHAPE_MAX && i < UINT8_MAX) schema->shape[position] = i + 1;
+        return &schema->fields[i];
+    }
+    return NULL;
+}
+
+// Validates and steps over a value without allocating
+const JsonSax json_skip_sax = {0};
+
+bool json_lexer_decode_field(JsonLexer* lexer, const JsonField* field, char* out) {
+    json_lexer_trim_left(lexer);
+    if (json_is_empty(lexer)) return json_lexer_fail(lexer, JSON_ERROR_EOF, 0);
+    void* at = out + field->offset;
+
+    // A null leaves the field as it was, like a missing key
+    size_t left = json_lexer_end(lexer) - lexer->cursor;
+    if (left >= 4 && memcmp(lexer->cursor, "null", 4) == 0) {
+        lexer->cursor += 4;
+        return true;
+    }
+
+    switch (field->type) {
+        case JSON_FIELD_NUMBER:
+        case JSON_FIELD_INTEGER: {
+            JsonNumber number;
+            const char* start = lexer->cursor;
+            if (!json_parse_number(lexer->cursor, json_lexer_end(lexer), &number, &lexer->cursor)) {
+                return json_lexer_fail(lexer, JSON_ERROR_NUMBER, 0);
+            }
+            if (field->type == JSON_FIELD_NUMBER) {
+                memcpy(at, &number.number, sizeof(number.number));
+                return true;
+            }
+            if (!number.is_integer) {
+                lexer->cursor = start;
+                return json_lexer_fail(lexer, JSON_ERROR_TYPE, 0);
+            }
+            memcpy(at, &number.integer, sizeof(number.integer));
+            return true;
+        }
+        case JSON_FIELD_BOOLEAN: {
+            bool boolean;
+            JsonCursor cursor = { lexer->cursor, json_lexer_end(lexer) };
+            if (!json_cursor_as_boolean(cursor, &boolean)) return json_lexer_fail(lexer, JSON_ERROR_TYPE, 0);
+            lexer->cursor += boolean ? 4 : 5;
+            memcpy(at, &boolean, sizeof(boolean));
+            return true;
+        }
+        case JSON_FIELD_STRING: {
+            if (*lexer->cursor != '"') return json_lexer_fail(lexer, JSON_ERROR_TYPE, 0);
+            lexer->cursor++;
+            AliSv string;
+            if (!json_lexer_read_string(lexer, &lexer->unescaped, &string)) return false;
+
+            JsonDomBuilder builder = json_lexer_dom_builder(lexer);
+            string = json_dom_string(&builder, string.start, string.len, false);
+            memcpy(at, &string, sizeof(string));
+            return true;
+        }
+        case JSON_FIELD_OBJECT:
+            return json_lexer_decode(lexer, field->schema, at);
+    }
+    return false;
+}
+
+bool json_lexer_decode(JsonLexer* lexer, JsonSchema* schema, void* out) {
+    json_lexer_trim_left(lexer);
+    if (!json_lexer_expect_char(lexer, '{')) return false;
+
+    json_lexer_trim_left(lexer);
+    if (!json_is_empty(lexer) && *lexer->cursor == '}') {
+        lexer->cursor++;
+        return true;
+    }
+
+    for (size_t position = 0; ; ++position) {
+        json_lexer_trim_left(lexer);
+        if (!json_lexer_expect_char(lexer, '"')) return false;
+        AliSv key;
+        if (!json_lexer_read_string(lexer, &lexer->unescaped, &key)) return false;
+
+        json_lexer_trim_left(lexer);
+        if (!json_lexer_expect_char(lexer, ':')) return false;
+
+        const JsonField* field = json_schema_field(schema, position, key.start, key.len);
+        bool ok = field != NULL
+            ? json_lexer_decode_field(lexer, field, out)
+            : json_lexer_parse_sax(lexer, &json_skip_sax, NULL);
+        if (!ok) return false;
+
+        json_lexer_trim_left(lexer);
+        if (json_is_empty(lexer) || *lexer->cursor != ',') break;
+        lexer->cursor++;
+    }
+    return json_lexer_expect_char(lexer, '}');
+}
+
+bool json_lexer_decode_each(JsonLexer* lexer, JsonSchema* schema, void* out, JsonDecodeFn fn, void* user) {
+    json_lexer_trim_left(lexer);
+    if (!json_lexer_expect_char(lexer, '[')) return false;
+
+    json_lexer_trim_left(lexer);
+    if (!json_is_empty(lexer) && *lexer->cursor == ']') {
+        lexer->cursor++;
+        return true;
+    }
+
+    for (;;) {
+        if (!json_lexer_decode(lexer, schema, out)) return false;
+        if (!fn(user, out)) return json_lexer_fail(lexer, JSON_ERROR_CALLBACK, 0);
+
+        json_lexer_trim_left(lexer);
+        if (json_is_empty(lexer) || *lexer->cursor != ',') break;
+        lexer->cursor++;
+    }
+    return json_lexer_expect_char(lexer, ']');
+}
+
+// Binary images
+
+#define JSON_BINARY_MAGIC 0x314e4942534a4c41ull // "ALJSBIN1"
+#define JSON_BINARY_HEADER_WORDS 3
+
+typedef struct {
+    uint32_t hash;
+    uint64_t offset; // of the string node, 0 for an empty slot
+}JsonBinaryKeySlot;
+
+typedef struct {
+    AliSb* sb;
+    size_t base; // start of the image in `sb`
+    // Words of the containers being written
+    AliSb scratch;
+
+    // Written keys, so repeated keys share one string node
+    JsonBinaryKeySlot* keys;
+    size_t keys_capacity;
+    size_t keys_len;
+}JsonBinaryWriter;
+
+uint64_t json_binary_push_word(JsonBinaryWriter* writer, uint64_t word) {
+    return json_scratch_push(writer->sb, &word, sizeof(word)) - sizeof(word) - writer->base;
+}
+
+uint64_t json_binary_push_string(JsonBinaryWriter* writer, AliSv string) {
+    uint64_t offset = json_binary_push_word(writer, string.len);
+    json_sb_push(writer->sb, string.start, string.len);
+
+    // NUL terminated and padded to the next word
+    size_t padding = 8 - string.len % 8;
+    json_sb_push(writer->sb, "\0\0\0\0\0\0\0\0", padding);
+    return offset;
+}
+
+AliSv json_binary_string_at(const char* data, uint64_t offset) {
+    uint64_t len;
+    memcpy(&len, data + offset, sizeof(len));
+    return ali_sv_from_parts((char*)data + offset + sizeof(len), len);
+}
+
+uint64_t json_binary_push_key(JsonBinaryWriter* writer, AliSv key) {
+    if ((writer->keys_len + 1) * 2 > writer->keys_capacity) {
+        size_t capacity = writer->keys_capacity == 0 ? 64 : writer->keys_capacity * 2;
+        JsonBinaryKeySlot* keys = ALI_MALLOC(capacity * sizeof(*keys));
+        memset(keys, 0, capacity * sizeof(*keys));
+        for (size_t i = 0; i < writer->keys_capacity; ++i) {
+            if (writer->keys[i].offset == 0) continue;
+            size_t at = writer->keys[i].hash & (capacity - 1);
+            while (keys[at].offset != 0) at = (at + 1) & (capacity - 1);
+            keys[at] = writer->keys[i];
+        }
+        ALI_FREE(writer->keys);
+        writer->keys = keys;
+        writer->keys_capacity = capacity;
+    }
+
+    uint32_t hash = json_hash_key(key.start, key.len);
+    size_t mask = writer->keys_capacity - 1;
+    size_t at = hash & mask;
+    const char* image = writer->sb->data + writer->base;
+    for (; writer->keys[at].offset != 0; at = (at + 1) & mask) {
+        if (writer->keys[at].hash != hash) continue;
+        AliSv written = json_binary_string_at(image, writer->keys[at].offset);
+        if (written.len == key.len && memcmp(written.start, key.start, key.len) == 0) return writer->keys[at].offset;
+    }
+
+    uint64_t offset = json_binary_push_string(writer, key);
+    writer->keys[at].hash = hash;
+    writer->keys[at].offset = offset;
+    writer->keys_len++;
+    return offset;
+}
+
+// Writes the nodes below `value` and returns the word that refers to it.
+// Children are written before their container, so their words are known.
+uint64_t json_binary_push_value(JsonBinaryWriter* writer, JsonValue* value) {
+    switch (value->type) {
+        case JSON_NUMBER:
+        case JSON_INTEGER: {
+            uint64_t bits;
+            memcpy(&bits, &value->as, sizeof(bits));
+            return json_tape_word(value->type == JSON_NUMBER ? JSON_TAPE_NUMBER : JSON_TAPE_INTEGER, json_binary_push_word(writer, bits));
+        }
+        case JSON_BOOLEAN:
+            return json_tape_word(value->as.boolean ? JSON_TAPE_TRUE : JSON_TAPE_FALSE, 0);
+        case JSON_NULL:
+            return json_tape_word(JSON_TAPE_NULL, 0);
+        case JSON_STRING:
+            return json_tape_word(JSON_TAPE_STRING, json_binary_push_string(writer, json_value_as_sv(value)));
+        case JSON_ARRAY:
+        case JSON_OBJECT: {
+            size_t base = writer->scratch.count;
+            size_t len;
+            if (value->type == JSON_ARRAY) {
+                len = value->as.array.len;
+                for (size_t i = 0; i < len; ++i) {
+                    uint64_t word = json_binary_push_value(writer, &value->as.array.items[i]);
+                    json_scratch_push(&writer->scratch, &word, sizeof(word));
+                }
+            } else {
+                len = value->as.object.len;
+                for (size_t i = 0; i < len; ++i) {
+                    JsonObjectItem* item = &value->as.object.items[i];
+                    uint64_t words[2] = { json_tape_word(JSON_TAPE_STRING, json_binary_push_key(writer, item->key)), 0 };
+                    words[1] = json_binary_push_value(writer, &item->value);
+                    json_scratch_push(&writer->scratch, words, sizeof(words));
+                }
+            }
+
+            uint64_t offset = json_binary_push_word(writer, len);
+            json_sb_push(writer->sb, writer->scratch.data + base, writer->scratch.count - base);
+            writer->scratch.count = base;
+            return json_tape_word(value->type == JSON_ARRAY ? JSON_TAPE_ARRAY_BEGIN : JSON_TAPE_OBJECT_BEGIN, offset);
+        }
+    }
+    ALI_UNREACHABLE();
+}
+
+void json_binary_write(AliSb* sb, JsonValue* value) {
+    // The image must start on a word boundary of its own
+    while (sb->count % 8 != 0) json_sb_push(sb, "", 1);
+
+    JsonBinaryWriter writer = {0};
+    writer.sb = sb;
+    writer.base = sb->count;
+
+    uint64_t header[JSON_BINARY_HEADER_WORDS] = { JSON_BINARY_MAGIC, 0, 0 };
+    json_scratch_push(sb, header, sizeof(header));
+    header[2] = json_binary_push_value(&writer, value);
+    header[1] = sb->count - writer.base;
+    memcpy(sb->data + writer.base, header, sizeof(header));
+
+    ALI_FREE(writer.keys);
+    ali_sb_free(&writer.scratch);
+}
+
+bool json_binary_save(const char* path, JsonValue* value) {
+    AliSb sb = {0};
+    json_binary_write(&sb, value);
+
+    FILE* f = fopen(path, "wb");
+    bool ok = f != NULL && fwrite(sb.data, 1, sb.count, f) == sb.count;
+    if (f != NULL && fclose(f) != 0) ok = false;
+    ali_sb_free(&sb);
+    return ok;
+}
+
+bool json_binary_from_memory(JsonBinary* binary, const void* data, size_t size) {
+    *binary = (JsonBinary) {0};
+    uint64_t header[JSON_BINARY_HEADER_WORDS];
+    if (size < sizeof(header) || (uintptr_t)data % 8 != 0) return false;
+
+    memcpy(header, data, sizeof(header));
+    if (header[0] != JSON_BINARY_MAGIC || header[1] > size) return false;
+
+    binary->data = data;
+    binary->size = header[1];
+    return true;
+}
+
+bool json_binary_open(JsonBinary* binary, const char* path) {
+    JsonFile file;
+    if (!json_file_open(&file, path)) return false;
+    if (!json_binary_from_memory(binary, file.data, file.size)) {
+        json_file_close(&file);
+        return false;
+    }
+    binary->file = file;
+    return true;
+}
+
+void json_binary_close(JsonBinary* binary) {
+    json_file_close(&binary->file);
+    *binary = (JsonBinary) {0};
+}
+
+const uint64_t* json_binary_node(JsonBinaryRef ref) {
+    return (const uint64_t*)(ref.binary->data + json_tape_payload(ref.word));
+}
+
+JsonBinaryRef json_binary_ref(const JsonBinary* binary, uint64_t word) {
+    JsonBinaryRef ref = { binary, word };
+    return ref;
+}
+
+JsonBinaryRef json_binary_root(const JsonBinary* binary) {
+    const uint64_t* header = (const uint64_t*)binary->data;
+    return json_binary_ref(binary, header[2]);
+}
+
+JsonValueType json_binary_type(JsonBinaryRef ref) {
+    switch (json_tape_tag(ref.word)) {
+        case JSON_TAPE_NUMBER: return JSON_NUMBER;
+        case JSON_TAPE_INTEGER: return JSON_INTEGER;
+        case JSON_TAPE_TRUE:
+        case JSON_TAPE_FALSE: return JSON_BOOLEAN;
+        case JSON_TAPE_NULL: return JSON_NULL;
+        case JSON_TAPE_STRING: return JSON_STRING;
+        case JSON_TAPE_ARRAY_BEGIN: return JSON_ARRAY;
+        case JSON_TAPE_OBJECT_BEGIN: return JSON_OBJECT;
+    }
+    // The empty ref, its word 0 has no tag
+    return JSON_NULL;
+}
+
+bool json_binary_as_number(JsonBinaryRef ref, double* number) {
+    if (json_tape_tag(ref.word) != JSON_TAPE_NUMBER) return false;
+    memcpy(number, json_binary_node(ref), sizeof(*number));
+    return true;
+}
+
+bool json_binary_as_integer(JsonBinaryRef ref, int64_t* integer) {
+    if (json_tape_tag(ref.word) != JSON_TAPE_INTEGER) return false;
+    memcpy(integer, json_binary_node(ref), sizeof(*integer));
+    return true;
+}
+
+AliSv json_binary_as_sv(JsonBinaryRef ref) {
+    if (json_tape_tag(ref.word) != JSON_TAPE_STRING) return ali_sv_from_parts(NULL, 0);
+    return json_binary_string_at(ref.binary->data, json_tape_payload(ref.word));
+}
+
+bool json_binary_as_boolean(JsonBinaryRef ref, bool* boolean) {
+    char tag = json_tape_tag(ref.word);
+    if (tag != JSON_TAPE_TRUE && tag != JSON_TAPE_FALSE) return false;
+    *boolean = tag == JSON_TAPE_TRUE;
+    return true;
+}
+
+size_t json_binary_len(JsonBinaryRef ref) {
+    char tag = json_tape_tag(ref.word);
+    if (tag != JSON_TAPE_ARRAY_BEGIN && tag != JSON_TAPE_OBJECT_BEGIN) return 0;
+    return json_binary_node(ref)[0];
+}
+
+JsonBinaryRef json_binary_array_get_item(JsonBinaryRef array, size_t index) {
+    if (json_tape_tag(array.word) != JSON_TAPE_ARRAY_BEGIN) return (JsonBinaryRef) {0};
+
+    const uint64_t* node = json_binary_node(array);
+    if (index >= node[0]) return (JsonBinaryRef) {0};
+    return json_binary_ref(array.binary, node[1 + index]);
+}
+
+AliSv json_binary_object_get_key(JsonBinaryRef object, size_t index) {
+    if (json_tape_tag(object.word) != JSON_TAPE_OBJECT_BEGIN) return ali_sv_from_parts(NULL, 0);
+
+    const uint64_t* node = json_binary_node(object);
+    if (index >= node[0]) return ali_sv_from_parts(NULL, 0);
+    return json_binary_as_sv(json_binary_ref(object.binary, node[1 + index * 2]));
+}
+
+JsonBinaryRef json_binary_object_get_value(JsonBinaryRef object, size_t index) {
+    if (json_tape_tag(object.word) != JSON_TAPE_OBJECT_BEGIN) return (JsonBinaryRef) {0};
+
+    const uint64_t* node = json_binary_node(object);
+    if (index >= node[0]) return (JsonBinaryRef) {0};
+    return json_binary_ref(object.binary, node[2 + index * 2]);
+}
+
+JsonBinaryRef json_binary_object_find_value(JsonBinaryRef object, char* key) {
+    size_t len = strlen(key);
+    size_t count = json_tape_tag(object.word) == JSON_TAPE_OBJECT_BEGIN ? json_binary_len(object) : 0;
+    for (size_t i = 0; i < count; ++i) {
+        AliSv item_key = json_binary_object_get_key(object, i);
+        if (item_key.len == len && memcmp(item_key.start, key, len) == 0) return json_binary_object_get_value(object, i);
+    }
+    return (JsonBinaryRef) {0};
+}
+
+// Serialization
+
+// Grisu2 over 64 bit "do it yourself" floats: f * 2^e
+typedef struct {
+    uint64_t f;
+    int e;
+}JsonDiyFp;
+
+JsonDiyFp json_diyfp_mul(JsonDiyFp a, JsonDiyFp b) {
+    uint64_t hi, lo;
+    json_mul128(a.f, b.f, &hi, &lo);
+    JsonDiyFp r = { hi + (lo >> 63), a.e + b.e + 64 };
+    return r;
+}
+
+JsonDiyFp json_diyfp_normalize(JsonDiyFp x) {
+    int shift = __builtin_clzll(x.f);
+    JsonDiyFp r = { x.f << shift, x.e - shift };
+    return r;
+}
+
+// 10^k normalized to 64 bits, taken from the same table the number parser uses.
+JsonDiyFp json_cached_pow10(int k) {
+    const uint64_t* pow5 = json_pow5_table[k - JSON_POW5_MIN];
+    JsonDiyFp r = { pow5[0] + (pow5[1] >> 63), ((217706 * k) >> 16) - 63 };
+    return r;
+}
+
+static const uint64_t json_pow10_u64[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull,
+};
+
+void json_grisu_round(char* digits, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        digits[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+// Produces the digits of a positive, finite double, subnormals included,
+// such that value == digits * 10^(*k).
+void json_grisu2(double value, char* digits, int* len, int* k) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int biased_e = (int)((bits >> 52) & 0x7FF);
+    JsonDiyFp v = { bits & (((uint64_t)1 << 52) - 1), 0 };
+    if (biased_e != 0) {
+        v.f += (uint64_t)1 << 52;
+        v.e = biased_e - 1075;
+    } else {
+        v.e = -1074;
+    }
+
+    // The boundaries m- and m+ halfway to the neighbouring doubles
+    JsonDiyFp plus = { (v.f << 1) + 1, v.e - 1 };
+    while (!(plus.f & ((uint64_t)1 << 53))) { plus.f <<= 1; plus.e--; }
+    plus.f <<= 10;
+    plus.e -= 10;
+    JsonDiyFp minus = v.f == ((uint64_t)1 << 52) ? (JsonDiyFp) { (v.f << 2) - 1, v.e - 2 } : (JsonDiyFp) { (v.f << 1) - 1, v.e - 1 };
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    // Bring the exponent of the scaled boundary into [-60, -32]
+    // ceil(x * log10(2)), x * log10(2) is never an integer for x != 0
+    int x = -61 - plus.e;
+    int mk = ((x * 78913) >> 18) + (x != 0);
+    JsonDiyFp c = json_cached_pow10(mk);
+    *k = -mk;
+
+    JsonDiyFp w = json_diyfp_mul(json_diyfp_normalize(v), c);
+    JsonDiyFp wp = json_diyfp_mul(plus, c);
+    JsonDiyFp wm = json_diyfp_mul(minus, c);
+    wm.f++;
+    wp.f--;
+
+    uint64_t delta = wp.f - wm.f;
+    JsonDiyFp one = { (uint64_t)1 << -wp.e, wp.e };
+    uint64_t wp_w = wp.f - w.f;
+    uint32_t p1 = (uint32_t)(wp.f >> -one.e);
+    uint64_t p2 = wp.f & (one.f - 1);
+
+    int kappa = 1;
+    while (kappa < 10 && p1 >= json_pow10_u64[kappa]) kappa++;
+
+    *len = 0;
+    while (kappa > 0) {
+        uint32_t div = (uint32_t)json_pow10_u64[kappa - 1];
+        uint32_t d = p1 / div;
+        p1 %= div;
+        if (d != 0 || *len != 0) digits[(*len)++] = (char)('0' + d);
+        kappa--;
+
+        uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+        if (rest <= delta) {
+            *k += kappa;
+            json_grisu_round(digits, *len, delta, rest, json_pow10_u64[kappa] << -one.e, wp_w);
+            return;
+        }
+    }
+
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> -one.e);
+        if (d != 0 || *len != 0) digits[(*len)++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *k += kappa;
+            int index = -kappa;
+            json_grisu_round(digits, *len, delta, p2, one.f, wp_w * (index < 20 ? json_pow10_u64[index] : 0));
+            return;
+        }
+    }
+}
+
+size_t json_format_u64(char* out, uint64_t n) {
+    char tmp[20];
+    size_t len = 0;
+    do {
+        tmp[len++] = (char)('0' + n % 10);
+        n /= 10;
+    } while (n != 0);
+    for (size_t i = 0; i < len; ++i) out[i] = tmp[len - 1 - i];
+    return len;
+}
+
+size_t json_format_integer(char* out, int64_t n) {
+    if (n >= 0) return json_format_u64(out, (uint64_t)n);
+    out[0] = '-';
+    return 1 + json_format_u64(out + 1, 0 - (uint64_t)n);
+}
+
+// Digits that parse back to the same double. They are the shortest such
+// in almost all cases: Grisu2 has no fallback for the rare ones where it
+// emits a digit more. NaN and infinities have no JSON representation and
+// are written as null. `out` needs room for 32 bytes.
+size_t json_format_number(char* out, double value) {
+    if (value != value || value - value != 0) {
+        memcpy(out, "null", 4);
+        return 4;
+    }
+
+    size_t len = 0;
+    if (signbit(value)) {
+        out[len++] = '-';
+        value = -value;
+    }
+    if (value == 0) {
+        out[len++] = '0';
+        return len;
+    }
+    if (value < 9007199254740992.0 && value == (double)(uint64_t)value) {
+        return len + json_format_u64(out + len, (uint64_t)value);
+    }
+
+    char digits[32];
+    int ndigits, k;
+    json_grisu2(value, digits, &ndigits, &k);
+
+    // The decimal point goes after the first `point` digits
+    int point = ndigits + k;
+    if (k >= 0 && point <= 21) {
+        memcpy(out + len, digits, ndigits);
+        len += ndigits;
+        for (int i = 0; i < k; ++i) out[len++] = '0';
+    } else if (point > 0 && point <= 21) {
+        memcpy(out + len, digits, point);
+        len += point;
+        out[len++] = '.';
+        memcpy(out + len, digits + point, ndigits - point);
+        len += ndigits - point;
+    } else if (point > -6 && point <= 0) {
+        out[len++] = '0';
+        out[len++] = '.';
+        for (int i = 0; i < -point; ++i) out[len++] = '0';
+        memcpy(out + len, digits, ndigits);
+        len += ndigits;
+    } else {
+        out[len++] = digits[0];
+        if (ndigits > 1) {
+            out[len++] = '.';
+            memcpy(out + len, digits + 1, ndigits - 1);
+            len += ndigits - 1;
+        }
+        out[len++] = 'e';
+        int exp = point - 1;
+        if (exp < 0) {
+            out[len++] = '-';
+            exp = -exp;
+        }
+        len += json_format_u64(out + len, (uint64_t)exp);
+    }
+    return len;
+}
+
+// Bytes that can't appear raw inside a JSON string
+bool json_needs_escape(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+// Unescaped runs are copied with one memcpy each.
+void json_stringify_string(AliSb* sb, AliSv string) {
+    static const char hex[] = "0123456789abcdef";
+
+    json_sb_push(sb, "\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < string.len; ++i) {
+        unsigned char c = string.start[i];
+        if (!json_needs_escape(c)) continue;
+
+        json_sb_push(sb, string.start + run, i - run);
+        run = i + 1;
+
+        char escaped[6] = { '\\', 0 };
+        size_t escaped_len = 2;
+        switch (c) {
+            case '"':  escaped[1] = '"'; break;
+            case '\\': escaped[1] = '\\'; break;
+            case '\b': escaped[1] = 'b'; break;
+            case '\f': escaped[1] = 'f'; break;
+            case '\n': escaped[1] = 'n'; break;
+            case '\r': escaped[1] = 'r'; break;
+            case '\t': escaped[1] = 't'; break;
+            default:
+                memcpy(escaped + 1, "u00", 3);
+                escaped[4] = hex[c >> 4];
+                escaped[5] = hex[c & 0xF];
+                escaped_len = 6;
+        }
+        json_sb_push(sb, escaped, escaped_len);
+    }
+    json_sb_push(sb, string.start + run, string.len - run);
+    json_sb_push(sb, "\"", 1);
+}
+
+void json_stringify_sb(AliSb* sb, JsonValue* value) {
+    switch (value->type) {
+        case JSON_NUMBER: {
+            ali_sb_maybe_resize(sb, 32);
+            sb->count += json_format_number(sb->data + sb->count, value->as.number);
+        } break;
+        case JSON_INTEGER: {
+            ali_sb_maybe_resize(sb, 32);
+            sb->count += json_format_integer(sb->data + sb->count, value->as.integer);
+        } break;
+        case JSON_STRING:
+            json_stringify_string(sb, json_value_as_sv(value));
+            break;
+        case JSON_BOOLEAN:
+            if (value->as.boolean) json_sb_push(sb, "true", 4);
+            else json_sb_push(sb, "false", 5);
+            break;
+        case JSON_NULL:
+            json_sb_push(sb, "null", 4);
+            break;
+        case JSON_ARRAY: {
+            json_sb_push(sb, "[", 1);
+            JsonArray* array = &value->as.array;
+            for (size_t i = 0; i < array->len; ++i) {
+                if (i > 0) json_sb_push(sb, ", ", 2);
+                json_stringify_sb(sb, &array->items[i]);
+            }
+            json_sb_push(sb, "]", 1);
+        } break;
+        case JSON_OBJECT: {
+            json_sb_push(sb, "{", 1);
+            JsonObject* object = &value->as.object;
+            for (size_t i = 0; i < object->len; ++i) {
+                if (i > 0) json_sb_push(sb, ", ", 2);
+                json_stringify_string(sb, object->items[i].key);
+                json_sb_push(sb, ": ", 2);
+                json_stringify_sb(sb, &object->items[i].value);
+            }
+            json_sb_push(sb, "}", 1);
+        }break;
+        default:
+            ALI_UNREACHABLE();
+    }
+}
+
+void json_stringify(JsonValue* value) {
+    AliSb sb = {0};
+    json_stringify_sb(&sb, value);
+    fwrite(sb.data, 1, sb.count, stdout);
+    ali_sb_free(&sb);
+}
+
+double* json_value_as_number(JsonValue* value) {
+    if (value->type != JSON_NUMBER) return NULL;
+    return &value->as.number;
+}
+
+int64_t* json_value_as_integer(JsonValue* value) {
+    if (value->type != JSON_INTEGER) return NULL;
+    return &value->as.integer;
+}
+
+char** json_value_as_string(JsonValue* value) {
+    if (value->type != JSON_STRING || json_value_is_inline(value)) return NULL;
+    return &value->as.string.start;
+}
+
+AliSv json_value_as_sv(JsonValue* value) {
+    if (value->type != JSON_STRING) return ali_sv_from_parts(NULL, 0);
+#if JSON_INLINE_STRING_MAX > 0
+    if (value->inline_len != 0) return ali_sv_from_parts(value->as.inline_string, value->inline_len - 1);
+#endif // JSON_INLINE_STRING_MAX
+    return value->as.string;
+}
+
+bool* json_value_as_boolean(JsonValue* value) {
+    if (value->type != JSON_BOOLEAN) return NULL;
+    return &value->as.boolean;
+}
+
+JsonArray* json_value_as_array(JsonValue* value) {
+    if (value->type != JSON_ARRAY) return NULL;
+    return &value->as.array;
+}
+
+JsonObject* json_value_as_object(JsonValue* value) {
+    if (value->type != JSON_OBJECT) return NULL;
+    return &value->as.object;
+}
+
+JsonValue* json_object_find_hashed(JsonObject* object, const char* key, size_t len, uint32_t hash) {
+    if (object->index != NULL) {
+        size_t mask = object->index->capacity - 1;
+
+        for (size_t slot = hash & mask; object->index->slots[slot].index != 0; slot = (slot + 1) & mask) {
+            JsonObjectIndexSlot* it = &object->index->slots[slot];
+            if (it->hash != hash) continue;
+
+            JsonObjectItem* item = &object->items[it->index - 1];
+            if (item->key.len == len && memcmp(item->key.start, key, len) == 0) return &item->value;
+        }
+        return NULL;
+    }
+
+    for (size_t i = 0; i < object->len; ++i) {
+        AliSv item_key = object->items[i].key;
+        if (item_key.len == len && memcmp(item_key.start, key, len) == 0) return &object->items[i].value;
+    }
+
+    return NULL;
+}
+
+JsonValue* json_object_find_interned(JsonObject* object, AliSv key) {
+    if (object->index != NULL) return json_object_find_hashed(object, key.start, key.len, json_hash_key(key.start, key.len));
+    for (size_t i = 0; i < object->len; ++i) {
+        AliSv item_key = object->items[i].key;
+        if (item_key.start == key.start && item_key.len == key.len) return &object->items[i].value;
+    }
     return NULL;
 }
 
+JsonValue* json_object_find_value(JsonObject* object, char* key) {
+    size_t len = strlen(key);
+    return json_object_find_hashed(object, key, len, json_hash_key(key, len));
+}
+
+// Copies and comparisons
+
+// Children are allocated right after their container, before the
+// children's own children.
+JsonValue json_value_clone(AliArena* arena, JsonValue* value) {
+    JsonValue clone = *value;
+    switch (value->type) {
+        case JSON_STRING: {
+            AliSv string = json_value_as_sv(value);
+            if (json_value_inline(&clone, string.start, string.len)) break;
+            clone.as.string = ali_sv_from_parts(json_strndup(arena, string.start, string.len), string.len);
+        } break;
+        case JSON_ARRAY: {
+            JsonArray* array = &value->as.array;
+            JsonValue* items = array->len > 0 ? json_alloc(arena, array->len * sizeof(*items)) : NULL;
+            for (size_t i = 0; i < array->len; ++i) items[i] = json_value_clone(arena, &array->items[i]);
+            clone.as.array = (JsonArray) { array->len, array->len, items };
+        } break;
+        case JSON_OBJECT: {
+            JsonObject* object = &value->as.object;
+            JsonObjectItem* items = object->len > 0 ? json_alloc(arena, object->len * sizeof(*items)) : NULL;
+            for (size_t i = 0; i < object->len; ++i) {
+                AliSv key = object->items[i].key;
+                items[i].key = ali_sv_from_parts(json_strndup(arena, key.start, key.len), key.len);
+                items[i].value = json_value_clone(arena, &object->items[i].value);
+            }
+            clone.as.object = (JsonObject) { object->len, object->len, items, NULL };
+            if (object->index != NULL) json_object_build_index(arena, &clone.as.object);
+        } break;
+        case JSON_NUMBER:
+        case JSON_INTEGER:
+        case JSON_BOOLEAN:
+        case JSON_NULL:
+            break;
+    }
+    return clone;
+}
+
+bool json_sv_equal(AliSv a, AliSv b) {
+    return a.len == b.len && memcmp(a.start, b.start, a.len) == 0;
+}
+
+// Whether `number` has exactly the value of `integer`
+bool json_number_is_integer(double number, int64_t integer) {
+    // 2^63 itself doesn't fit
+    if (!(number >= -9223372036854775808.0 && number < 9223372036854775808.0)) return false;
+    return (int64_t)number == integer && (double)(int64_t)number == number;
+}
+
+bool json_value_equal(JsonValue* a, JsonValue* b) {
+    if (a->type == JSON_NUMBER && b->type == JSON_INTEGER) return json_number_is_integer(a->as.number, b->as.integer);
+    if (a->type == JSON_INTEGER && b->type == JSON_NUMBER) return json_number_is_integer(b->as.number, a->as.integer);
+    if (a->type != b->type) return false;
+
+    switch (a->type) {
+        case JSON_NUMBER: return a->as.number == b->as.number;
+        case JSON_INTEGER: return a->as.integer == b->as.integer;
+        case JSON_BOOLEAN: return a->as.boolean == b->as.boolean;
+        case JSON_NULL: return true;
+        case JSON_STRING: return json_sv_equal(json_value_as_sv(a), json_value_as_sv(b));
+        case JSON_ARRAY: {
+            if (a->as.array.len != b->as.array.len) return false;
+            for (size_t i = 0; i < a->as.array.len; ++i) {
+                if (!json_value_equal(&a->as.array.items[i], &b->as.array.items[i])) return false;
+            }
+            return true;
+        }
+        case JSON_OBJECT: {
+            JsonObject* object = &b->as.object;
+            if (a->as.object.len != object->len) return false;
+            for (size_t i = 0; i < object->len; ++i) {
+                JsonObjectItem* item = &a->as.object.items[i];
+                // Objects built from the same source keep their order, so the
+                // item in the same position is tried before a lookup
+                JsonValue* other = json_sv_equal(item->key, object->items[i].key)
+                    ? &object->items[i].value
+                    : json_object_find_hashed(object, item->key.start, item->key.len, json_hash_key(item->key.start, item->key.len));
+                if (other == NULL || !json_value_equal(&item->value, other)) return false;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// splitmix64 finalizer
+uint64_t json_hash_mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+// 64 bit FNV-1a
+uint64_t json_hash_bytes(const char* bytes, size_t len) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (uint8_t)bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t json_hash_number(double number) {
+    // -0 == 0, so both need the same bits
+    if (number == 0) number = 0;
+    uint64_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+    return json_hash_mix(json_hash_mix(JSON_NUMBER + 1) ^ bits);
+}
+
+uint64_t json_value_hash(JsonValue* value) {
+    uint64_t hash = json_hash_mix(value->type + 1);
+    switch (value->type) {
+        case JSON_NUMBER:
+            return json_hash_number(value->as.number);
+        case JSON_INTEGER: {
+            // Integers that a double holds exactly can equal a number
+            double number = (double)value->as.integer;
+            if (json_number_is_integer(number, value->as.integer)) return json_hash_number(number);
+            return json_hash_mix(hash ^ (uint64_t)value->as.integer);
+        }
+        case JSON_BOOLEAN:
+            return json_hash_mix(hash ^ value->as.boolean);
+        case JSON_NULL:
+            return hash;
+        case JSON_STRING: {
+            AliSv string = json_value_as_sv(value);
+            return json_hash_mix(hash ^ json_hash_bytes(string.start, string.len));
+        }
+        case JSON_ARRAY:
+            for (size_t i = 0; i < value->as.array.len; ++i) {
+                hash = json_hash_mix(hash ^ json_value_hash(&value->as.array.items[i]));
+            }
+            return json_hash_mix(hash ^ value->as.array.len);
+        case JSON_OBJECT: {
+            // A sum of the item hashes doesn't depend on their order
+            uint64_t items = 0;
+            for (size_t i = 0; i < value->as.object.len; ++i) {
+                JsonObjectItem* item = &value->as.object.items[i];
+                uint64_t key = json_hash_bytes(item->key.start, item->key.len);
+                items += json_hash_mix(key ^ json_hash_mix(json_value_hash(&item->value)));
+            }
+            return json_hash_mix(hash ^ items ^ value->as.object.len);
+        }
+    }
+    return hash;
+}
+
+// Editing
+
+// Small blocks only need the link, large ones also remember their size
+typedef struct JsonFreeBlock {
+    struct JsonFreeBlock* next;
+    size_t size;
+}JsonFreeBlock;
+
+JsonEditor json_editor(AliArena* arena) {
+    JsonEditor editor = {0};
+    editor.arena = arena;
+    return editor;
+}
+
+// Blocks are never split or merged, so memory doesn't fragment
+void** json_editor_free_list(JsonEditor* editor, size_t size) {
+    if (size <= JSON_EDITOR_SMALL_MAX) return &editor->small[size / 8 - 1];
+    return &editor->large[(size / 8) % JSON_EDITOR_LARGE_CLASSES];
+}
+
+void json_editor_free(JsonEditor* editor, void* block, size_t size) {
+    size &= ~(size_t)7;
+    if (block == NULL || size == 0) return;
+
+    void** list = json_editor_free_list(editor, size);
+    JsonFreeBlock* free_block = block;
+    free_block->next = *list;
+    if (size > JSON_EDITOR_SMALL_MAX) free_block->size = size;
+    *list = free_block;
+}
+
+void* json_editor_alloc(JsonEditor* editor, size_t size) {
+    size = size == 0 ? 8 : (size + 7) & ~(size_t)7;
+
+    JsonFreeBlock** link = (JsonFreeBlock**)json_editor_free_list(editor, size);
+    if (size > JSON_EDITOR_SMALL_MAX) {
+        while (*link != NULL && (*link)->size != size) link = &(*link)->next;
+    }
+    if (*link == NULL) return json_alloc(editor->arena, size);
+
+    JsonFreeBlock* block = *link;
+    *link = block->next;
+    return block;
+}
+
+char* json_editor_strndup(JsonEditor* editor, const char* string, size_t len) {
+    char* copy = json_editor_alloc(editor, len + 1);
+    memcpy(copy, string, len);
+    copy[len] = 0;
+    return copy;
+}
+
+// Every string block was rounded up by json_alloc
+void json_editor_free_string(JsonEditor* editor, AliSv string) {
+    if (editor->free_strings) json_editor_free(editor, string.start, (string.len + 1 + 7) & ~(size_t)7);
+}
+
+void json_editor_release(JsonEditor* editor, JsonValue* value) {
+    switch (value->type) {
+        case JSON_STRING:
+            if (!json_value_is_inline(value)) json_editor_free_string(editor, value->as.string);
+            break;
+        case JSON_ARRAY: {
+            JsonArray* array = &value->as.array;
+            for (size_t i = 0; i < array->len; ++i) json_editor_release(editor, &array->items[i]);
+            json_editor_free(editor, array->items, array->capacity * sizeof(*array->items));
+        } break;
+        case JSON_OBJECT: {
+            JsonObject* object = &value->as.object;
+            for (size_t i = 0; i < object->len; ++i) {
+                json_editor_free_string(editor, object->items[i].key);
+                json_editor_release(editor, &object->items[i].value);
+            }
+            json_editor_free(editor, object->items, object->capacity * sizeof(*object->items));
+            if (object->index != NULL) json_editor_free(editor, object->index, json_object_index_size(object->index->capacity));
+        } break;
+        case JSON_NUMBER:
+        case JSON_INTEGER:
+        case JSON_BOOLEAN:
+        case JSON_NULL:
+            break;
+    }
+    *value = json_value_null();
+}
+
+// Grows `items` to hold at least `len + 1` elements of `item_size` bytes.
+// Doubling keeps the copying linear, the old storage goes back on the
+// free lists.
+void* json_editor_grow(JsonEditor* editor, void* items, size_t len, size_t* capacity, size_t item_size) {
+    if (len < *capacity) return items;
+
+    size_t new_capacity = *capacity == 0 ? JSON_CONTAINER_INIT_CAPACITY : *capacity * 2;
+    void* new_items = json_editor_alloc(editor, new_capacity * item_size);
+    if (len > 0) memcpy(new_items, items, len * item_size);
+    json_editor_free(editor, items, *capacity * item_size);
+    *capacity = new_capacity;
+    return new_items;
+}
+
+bool json_array_insert(JsonEditor* editor, JsonArray* array, size_t index, JsonValue value) {
+    if (index > array->len) return false;
+    array->items = json_editor_grow(editor, array->items, array->len, &array->capacity, sizeof(*array->items));
+    memmove(&array->items[index + 1], &array->items[index], (array->len - index) * sizeof(*array->items));
+    array->items[index] = value;
+    array->len++;
+    return true;
+}
+
+bool json_array_replace(JsonEditor* editor, JsonArray* array, size_t index, JsonValue value) {
+    if (index >= array->len) return false;
+    json_editor_release(editor, &array->items[index]);
+    array->items[index] = value;
+    return true;
+}
+
+bool json_array_remove(JsonEditor* editor, JsonArray* array, size_t index) {
+    if (index >= array->len) return false;
+    json_editor_release(editor, &array->items[index]);
+    memmove(&array->items[index], &array->items[index + 1], (array->len - index - 1) * sizeof(*array->items));
+    array->len--;
+    return true;
+}
+
+// Rebuilds the index after items moved. Objects that grew to
+// JSON_OBJECT_INDEX_THRESHOLD keys get one, like parsed objects.
+void json_editor_reindex(JsonEditor* editor, JsonObject* object) {
+    if (object->index == NULL && object->len < JSON_OBJECT_INDEX_THRESHOLD) return;
+
+    size_t capacity = json_object_index_capacity(object->len);
+    if (object->index == NULL || object->index->capacity != capacity) {
+        if (object->index != NULL) json_editor_free(editor, object->index, json_object_index_size(object->index->capacity));
+        object->index = json_editor_alloc(editor, json_object_index_size(capacity));
+        object->index->capacity = capacity;
+    }
+    json_object_index_fill(object->index, object);
+}
+
+// Position of `key` in the items, or object->len
+size_t json_object_find_position(JsonObject* object, const char* key, size_t len) {
+    JsonValue* value = json_object_find_hashed(object, key, len, json_hash_key(key, len));
+    if (value == NULL) return object->len;
+    return (JsonObjectItem*)((char*)value - offsetof(JsonObjectItem, value)) - object->items;
+}
+
+bool json_object_insert(JsonEditor* editor, JsonObject* object, size_t index, const char* key, JsonValue value) {
+    size_t len = strlen(key);
+    if (index > object->len || json_object_find_position(object, key, len) < object->len) return false;
+
+    object->items = json_editor_grow(editor, object->items, object->len, &object->capacity, sizeof(*object->items));
+    memmove(&object->items[index + 1], &object->items[index], (object->len - index) * sizeof(*object->items));
+    object->items[index].key = ali_sv_from_parts(json_editor_strndup(editor, key, len), len);
+    object->items[index].value = value;
+    object->len++;
+
+    // Appending keeps the positions of the other keys
+    if (index + 1 == object->len && object->index != NULL && object->len * 2 <= object->index->capacity) {
+        json_object_index_insert(object->index, json_hash_key(key, len), index);
+    } else {
+        json_editor_reindex(editor, object);
+    }
+    return true;
+}
+
+bool json_object_replace(JsonEditor* editor, JsonObject* object, const char* key, JsonValue value) {
+    size_t position = json_object_find_position(object, key, strlen(key));
+    if (position == object->len) return false;
+    json_editor_release(editor, &object->items[position].value);
+    object->items[position].value = value;
+    return true;
+}
+
+bool json_object_remove(JsonEditor* editor, JsonObject* object, const char* key) {
+    size_t position = json_object_find_position(object, key, strlen(key));
+    if (position == object->len) return false;
+
+    json_editor_free_string(editor, object->items[position].key);
+    json_editor_release(editor, &object->items[position].value);
+    memmove(&object->items[position], &object->items[position + 1], (object->len - position - 1) * sizeof(*object->items));
+    object->len--;
+    json_editor_reindex(editor, object);
+    return true;
+}
+
+void json_object_set(JsonEditor* editor, JsonObject* object, const char* key, JsonValue value) {
+    if (!json_object_replace(editor, object, key, value)) json_object_insert(editor, object, object->len, key, value);
+}
+
 #endif // JSON_IMPLEMENTATION
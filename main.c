@@ -6,9 +6,8 @@
 #include "json.h"
 
 int main(void) {
-    AliSb sb = {0};
-    if (!sb_read_file(&sb, "products.json")) return 1;
-    JsonLexer lexer = json_lexer(sb.data, sb.count);
+    JsonLexer lexer;
+    if (!json_lexer_from_file(&lexer, "products.json", NULL)) return 1;
 
     JsonValue value;
     if (!json_lexer_parse_value(&lexer, &value)) return 1;
@@ -28,5 +27,6 @@ int main(void) {
         printf("\n");
     }
 
+    json_lexer_free(&lexer);
     return 0;
 }
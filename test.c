@@ -0,0 +1,452 @@
+// Regression tests, `make test` builds and runs them. Each test returns
+// false on the first failed check, after printing it.
+#include <float.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALI_REMOVE_PREFIX
+#define ALI_IMPLEMENTATION
+#include "ali.h"
+
+#define JSON_IMPLEMENTATION
+#include "json.h"
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond); \
+            return false; \
+        } \
+    } while (0)
+
+// Lookups through a value that isn't there find nothing again
+static bool test_cursor_missing(void) {
+    const char* content = "{\"products\": [{\"id\": 1}, {\"id\": 2}]}";
+    JsonCursor root = json_cursor(content, strlen(content));
+    JsonCursor products = json_cursor_find_value(root, "products");
+    TEST_CHECK(products.start != NULL);
+
+    JsonCursor id = json_cursor_find_value(json_cursor_get_item(products, 1), "id");
+    double number = 0;
+    TEST_CHECK(json_cursor_as_number(id, &number) && number == 2);
+
+    JsonCursor missing = json_cursor_find_value(json_cursor_get_item(products, 1000), "id");
+    TEST_CHECK(missing.start == NULL);
+    TEST_CHECK(json_cursor_type(missing) == JSON_NULL);
+    TEST_CHECK(!json_cursor_as_number(missing, &number));
+    bool boolean;
+    TEST_CHECK(!json_cursor_as_boolean(missing, &boolean));
+    TEST_CHECK(json_cursor_as_sv(missing).start == NULL);
+    TEST_CHECK(json_cursor_first(missing).start == NULL);
+    TEST_CHECK(json_cursor_next(missing).start == NULL);
+    TEST_CHECK(json_cursor_get_item(json_cursor_find_value(root, "nope"), 0).start == NULL);
+
+    JsonCursor empty = json_cursor("", 0);
+    TEST_CHECK(empty.start == NULL);
+    TEST_CHECK(json_cursor_find_value(json_cursor_get_item(empty, 0), "id").start == NULL);
+    JsonValue value;
+    TEST_CHECK(!json_cursor_parse(empty, NULL, &value));
+    return true;
+}
+
+// The tree of a cursor parse outlives the call, in the caller's arena
+static bool test_cursor_parse(void) {
+    const char* content = "{\"a\": [1, 2, 3, \"hello world string\"], \"b\": {\"c\\n\": true}}";
+    JsonCursor root = json_cursor(content, strlen(content));
+    JsonValue value;
+    TEST_CHECK(!json_cursor_parse(json_cursor_find_value(root, "a"), NULL, &value));
+
+    AliArena arena = {0};
+    TEST_CHECK(json_cursor_parse(json_cursor_find_value(root, "a"), &arena, &value));
+    TEST_CHECK(value.type == JSON_ARRAY && value.as.array.len == 4);
+    TEST_CHECK(value.as.array.items[3].type == JSON_STRING);
+    AliSv string = json_value_as_sv(&value.as.array.items[3]);
+    TEST_CHECK(string.len == 18 && memcmp(string.start, "hello world string", 18) == 0);
+
+    TEST_CHECK(json_cursor_parse(json_cursor_find_value(root, "b"), &arena, &value));
+    TEST_CHECK(value.type == JSON_OBJECT && value.as.object.len == 1);
+    TEST_CHECK(value.as.object.items[0].key.len == 2 && memcmp(value.as.object.items[0].key.start, "c\n", 2) == 0);
+    TEST_CHECK(value.as.object.items[0].value.type == JSON_BOOLEAN);
+    ali_arena_free(&arena);
+    return true;
+}
+
+static bool test_tape_missing(void) {
+    const char* content = "{\"products\": [{\"id\": 1.5}, {\"id\": 2.5}]}";
+    JsonLexer lexer = json_lexer(content, strlen(content));
+    JsonTape tape;
+    TEST_CHECK(json_lexer_parse_tape(&lexer, &tape));
+
+    JsonTapeRef products = json_tape_object_find_value(json_tape_root(&tape), "products");
+    double number = 0;
+    TEST_CHECK(json_tape_as_number(json_tape_object_find_value(json_tape_array_get_item(products, 1), "id"), &number));
+    TEST_CHECK(number == 2.5);
+
+    JsonTapeRef missing = json_tape_object_find_value(json_tape_object_find_value(json_tape_root(&tape), "nope"), "id");
+    TEST_CHECK(missing.tape == NULL);
+    TEST_CHECK(json_tape_type(missing) == JSON_NULL);
+    TEST_CHECK(!json_tape_as_number(missing, &number));
+    bool boolean;
+    TEST_CHECK(!json_tape_as_boolean(missing, &boolean));
+    TEST_CHECK(json_tape_as_sv(missing).start == NULL);
+    TEST_CHECK(json_tape_len(missing) == 0);
+    TEST_CHECK(json_tape_first(missing).tape == NULL);
+    TEST_CHECK(json_tape_next(missing).tape == NULL);
+    TEST_CHECK(json_tape_array_get_item(json_tape_array_get_item(products, 1000), 0).tape == NULL);
+
+    json_lexer_free(&lexer);
+    return true;
+}
+
+static bool test_binary_missing(void) {
+    const char* content = "{\"products\": [{\"id\": 1}, {\"id\": 2}]}";
+    JsonLexer lexer = json_lexer(content, strlen(content));
+    JsonValue value;
+    TEST_CHECK(json_lexer_parse_value(&lexer, &value));
+
+    AliSb image = {0};
+    json_binary_write(&image, &value);
+    JsonBinary binary;
+    TEST_CHECK(json_binary_from_memory(&binary, image.data, image.count));
+
+    JsonBinaryRef products = json_binary_object_find_value(json_binary_root(&binary), "products");
+    TEST_CHECK(json_binary_type(products) == JSON_ARRAY);
+
+    JsonBinaryRef missing = json_binary_object_find_value(json_binary_array_get_item(products, 1000), "id");
+    TEST_CHECK(missing.binary == NULL);
+    TEST_CHECK(json_binary_type(missing) == JSON_NULL);
+    double number;
+    TEST_CHECK(!json_binary_as_number(missing, &number));
+    TEST_CHECK(json_binary_as_sv(missing).start == NULL);
+    TEST_CHECK(json_binary_len(missing) == 0);
+    TEST_CHECK(json_binary_object_get_key(missing, 0).start == NULL);
+    TEST_CHECK(json_binary_object_get_value(missing, 0).binary == NULL);
+
+    sb_free(&image);
+    json_lexer_free(&lexer);
+    return true;
+}
+
+static bool test_parse(const char* content, size_t len, JsonErrorCode expected) {
+    JsonLexer lexer = json_lexer(content, len);
+    JsonValue value;
+    bool ok = json_lexer_parse_value(&lexer, &value);
+    JsonErrorCode code = lexer.error.code;
+    json_lexer_free(&lexer);
+    return ok ? expected == JSON_ERROR_NONE : code == expected;
+}
+
+// Raw control chars must be escaped, before and after a 64 byte block
+// and after an escape
+static bool test_string_control_chars(void) {
+    TEST_CHECK(test_parse("\"tab\there\"", 10, JSON_ERROR_STRING));
+    TEST_CHECK(test_parse("\"a\\n\nb\"", 7, JSON_ERROR_STRING));
+    TEST_CHECK(test_parse("\"tab\\there\"", 11, JSON_ERROR_NONE));
+    TEST_CHECK(test_parse("[\"\x7f\"]", 5, JSON_ERROR_NONE));
+
+    char content[200];
+    for (size_t at = 1; at < 150; ++at) {
+        memset(content, 'a', sizeof(content));
+        content[0] = '"';
+        content[160] = '"';
+        TEST_CHECK(test_parse(content, 161, JSON_ERROR_NONE));
+        content[at] = 0x1f;
+        TEST_CHECK(test_parse(content, 161, JSON_ERROR_STRING));
+        content[at] = (char)0xc3;
+        content[at + 1] = (char)0xa9;
+        TEST_CHECK(test_parse(content, 161, JSON_ERROR_NONE));
+    }
+    return true;
+}
+
+// Validates `content` and parses it as a whole document with
+// json_lexer_parse_many and the same max depth, both must fail at the same
+// byte with the same error. json_lexer_parse_value isn't the reference, it
+// accepts content after the value.
+static bool test_agree(const char* content, size_t len, size_t max_depth) {
+    JsonError validated;
+    bool valid = json_validate(content, len, max_depth, &validated);
+
+    JsonLexer lexer = json_lexer(content, 0);
+    lexer.max_depth = max_depth;
+    AliSv document = { (char*)content, len };
+    bool parsed = json_lexer_parse_many(&lexer, &document, 1, NULL, NULL) == 1;
+    JsonError error = parsed ? (JsonError) {0} : lexer.error;
+    json_lexer_free(&lexer);
+
+    if (valid != parsed || validated.code != error.code || validated.offset != error.offset) {
+        printf("\"%.*s\": validate %d at %zu, parse %d at %zu\n", (int)len, content,
+            validated.code, validated.offset, error.code, error.offset);
+        return false;
+    }
+    return true;
+}
+
+static bool test_validate_agrees(void) {
+    static const char* const cases[] = {
+        "", " ", "1", "-", "-0", "01", "1.", "1e", "1e+5", "-0.5e-3", "tru", "true", "nul", "null ",
+        "[1,]", "[,1]", "[1 2]", "{\"a\":1,}", "{\"a\" 1}", "{1:2}", "{\"a\":}", "[[]]]", "{} {}",
+        "\"", "\"abc", "\"a\\", "\"a\\\"", "\"\\x\"", "\"\\u12\"", "\"\\u12g4\"", "\"\\u00e9\"",
+        "\"\\ud800\"", "\"\\ud83d\\ude00\"", "\"\\/\"", "\"a\tb\"", "\"\x7f\"",
+        "\"\xc3\xa9\"", "\"\xc3\"", "\"\xc3(\"", "\"\xc0\x80\"", "\"\xed\xa0\x80\"", "\"\xf4\x90\x80\x80\"",
+        "\"\xf0\x9f\x98\x80\"", "\"\xff\"", "[\"a\\n\x01\"]", "{\"\xe9\":1}", "[\"\xe2\x82\"]",
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        TEST_CHECK(test_agree(cases[i], strlen(cases[i]), 0));
+    }
+    TEST_CHECK(test_agree("\"a\0b\"", 5, 0));
+
+    // Either side of the limit, for the default and for a set depth
+    static char content[5 * 2 * JSON_MAX_DEPTH + 8];
+    size_t depths[] = { 1, 2, 3, 64, 65, JSON_MAX_DEPTH, JSON_MAX_DEPTH + 1, 2 * JSON_MAX_DEPTH };
+    for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); ++i) {
+        size_t depth = depths[i];
+        for (size_t nesting = depth - 1; nesting <= depth + 1; ++nesting) {
+            size_t len = 0;
+            for (size_t j = 0; j < nesting; ++j) {
+                const char* open = j % 2 == 0 ? "[" : "{\"\":";
+                memcpy(content + len, open, strlen(open));
+                len += strlen(open);
+            }
+            content[len++] = '1';
+            for (size_t j = nesting; j-- > 0;) content[len++] = j % 2 == 0 ? ']' : '}';
+
+            TEST_CHECK(test_agree(content, len, depth));
+            if (depth == JSON_MAX_DEPTH) TEST_CHECK(test_agree(content, len, 0));
+        }
+    }
+    return true;
+}
+
+static bool test_number_is(const char* literal, double expected) {
+    JsonNumber number;
+    const char* end;
+    if (!json_parse_number(literal, literal + strlen(literal), &number, &end)) return false;
+    if (memcmp(&number.number, &expected, sizeof(expected)) != 0) {
+        printf("%s: %.17g, expected %.17g\n", literal, number.number, expected);
+        return false;
+    }
+    return true;
+}
+
+// Literals of more than 19 significant digits right at, just below and
+// just above the halfway point between two doubles, the point printed
+// exactly from a long double. glibc's strtod is exact in the C locale.
+static bool test_number_long_digits(void) {
+    TEST_CHECK(test_number_is("2.4703282292062327208828439643411068618252990130716238221279284125033775363510437593264991818081799618989828234772285886546332835517796989819938739800539093906315035659515570226392290858392449105184435931802849936536152500319370457678249219365623669863658480757001585769269903706311928279558551332927834338409351978015531246597263579574622766465272827220056374006485499977096599470454020828166226237857393450736339007967761930577506740176324673600968951340535537458516661134223766678604162159680461914467291840300530057530849048765391711386591646239524912623653881879636239373280423891018672348497668235089863388587925628302755995657524455507255189313690836254779186948667994968324049705821028513185451396213837722826145437693412532098591327667236328125e-324", 0.0));
+    TEST_CHECK(test_number_is("2.47032822920623272088284396434110686182529901307162382212792841250337753635104375932649918180817996189898282347722858865463328355177969898199387398005390939063150356595155702263922908583924491051844359318028499365361525003193704576782492193656236698636584807570015857692699037063119282795585513329278343384093519780155312465972635795746227664652728272200563740064854999770965994704540208281662262378573934507363390079677619305775067401763246736009689513405355374585166611342237666786041621596804619144672918403005300575308490487653917113865916462395249126236538818796362393732804238910186723484976682350898633885879256283027559956575244555072551893136908362547791869486679949683240497058210285131854513962138377228261454376934125320985913276672363281251e-324", 5e-324));
+    TEST_CHECK(test_number_is("-1.00000000000000011102230246251565404236316680908203125", -1.0));
+    TEST_CHECK(test_number_is("1.00000000000000011102230246251565404236316680908203126", 1.0000000000000002));
+    TEST_CHECK(test_number_is("179769313486231580793728971405303415079934132710037826936173778980444968292764750946649017977587207096330286416692887910946555547851940402630657488671505820681908902000708383676273854845817711531764475730270069855571366959622842914819860834936475292719074168444365510704342711559699508093042880177904174497792e0", HUGE_VAL));
+    TEST_CHECK(test_number_is("0.000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000004940656458412465441765687928682213723651", 5e-324));
+
+#if LDBL_MANT_DIG >= 64
+    static const double seeds[] = { 1.0, 0.1, 3.141592653589793, 1e23, 8.98846567431158e307, 1.7976931348623157e308, 2.2250738585072014e-308, 2.225073858507201e-308, 1e-310, 5e-324, 123456789012345680.0, 9007199254740993.0 };
+    char literal[1200];
+    for (size_t i = 0; i < sizeof(seeds) / sizeof(seeds[0]); ++i) {
+        double low = seeds[i];
+        uint64_t bits;
+        memcpy(&bits, &low, sizeof(bits));
+        for (int step = 0; step < 64; ++step, ++bits) {
+            double x, next;
+            memcpy(&x, &bits, sizeof(x));
+            uint64_t next_bits = bits + 1;
+            memcpy(&next, &next_bits, sizeof(next));
+            if (next == HUGE_VAL) break;
+
+            long double halfway = (long double)x + ((long double)next - (long double)x) / 2;
+            snprintf(literal, sizeof(literal), "%.800Le", halfway);
+            char* e = strchr(literal, 'e');
+            char exponent[16];
+            snprintf(exponent, sizeof(exponent), "%s", e);
+
+            // Exactly halfway, then a hair above it
+            TEST_CHECK(test_number_is(literal, strtod(literal, NULL)));
+            snprintf(e, sizeof(literal) - (e - literal), "1%s", exponent);
+            TEST_CHECK(test_number_is(literal, next));
+            // And a hair below: the last nonzero digit minus one, then nines
+            snprintf(e, sizeof(literal) - (e - literal), "%s", exponent);
+            char* digit = e - 1;
+            for (; *digit == '0' || *digit == '.'; --digit) {
+                if (*digit == '0') *digit = '9';
+            }
+            (*digit)--;
+            TEST_CHECK(test_number_is(literal, x));
+        }
+    }
+#endif
+    return true;
+}
+
+// Parses `content` serially and in parallel with the same max depth and
+// flags, both must fail at the same byte with the same error or build the
+// same tree. With JSON_PARSE_INTERN every key of the parallel tree must be
+// the copy in the lexer's table.
+static bool test_parallel_agrees(const char* content, size_t len, size_t max_depth, unsigned flags) {
+    JsonLexer serial = json_lexer(content, len);
+    serial.max_depth = max_depth;
+    serial.flags = flags;
+    JsonValue value;
+    bool serial_ok = json_lexer_parse_value(&serial, &value);
+
+    JsonLexer parallel = json_lexer(content, len);
+    parallel.max_depth = max_depth;
+    parallel.flags = flags;
+    JsonValue parallel_value;
+    bool parallel_ok = json_lexer_parse_parallel(&parallel, &parallel_value, 4);
+
+    bool same = serial_ok == parallel_ok && serial.error.code == parallel.error.code && serial.error.offset == parallel.error.offset;
+    if (same && serial_ok) same = json_value_equal(&value, &parallel_value);
+    if (same && serial_ok && (flags & JSON_PARSE_INTERN) && parallel_value.type == JSON_ARRAY) {
+        AliSv id = json_intern(&parallel.intern, NULL, "id", 2);
+        for (size_t i = 0; i < parallel_value.as.array.len && same; ++i) {
+            JsonValue* item = &parallel_value.as.array.items[i];
+            same = item->type != JSON_OBJECT || json_object_find_interned(&item->as.object, id) != NULL;
+        }
+        if (!same) printf("interned key missing\n");
+    }
+    if (!same) {
+        printf("max depth %zu: serial %d at %zu, parallel %d at %zu\n", max_depth,
+            serial.error.code, serial.error.offset, parallel.error.code, parallel.error.offset);
+    }
+    json_lexer_free(&serial);
+    json_lexer_free(&parallel);
+    return same;
+}
+
+// Elements of a large array, below a few objects, nested `nesting` deep
+static bool test_parallel_depth(void) {
+    size_t sizes[] = { 0, 1, 3, 8 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        size_t nesting = sizes[i];
+        AliSb sb = {0};
+        json_sb_push(&sb, "{\"a\": {\"b\": [", 13);
+        while (sb.count < JSON_PARALLEL_MIN_SIZE + 1024) {
+            for (size_t j = 0; j < nesting; ++j) json_sb_push(&sb, "[", 1);
+            json_sb_push(&sb, "12", 2);
+            for (size_t j = 0; j < nesting; ++j) json_sb_push(&sb, "]", 1);
+            json_sb_push(&sb, ", ", 2);
+        }
+        json_sb_push(&sb, "0]}}", 4);
+
+        // The array is the third container, its elements add `nesting` more
+        for (size_t max_depth = 1; max_depth <= nesting + 4; ++max_depth) {
+            TEST_CHECK(test_parallel_agrees(sb.data, sb.count, max_depth, 0));
+        }
+        TEST_CHECK(test_parallel_agrees(sb.data + 12, sb.count - 14, nesting + 1, 0));
+        TEST_CHECK(test_parallel_agrees(sb.data + 12, sb.count - 14, nesting, 0));
+        sb_free(&sb);
+    }
+    return true;
+}
+
+// Keys and short strings interned by the workers end up in the lexer's table
+static bool test_parallel_intern(void) {
+    AliSb sb = {0};
+    json_sb_push(&sb, "[", 1);
+    for (size_t i = 0; sb.count < JSON_PARALLEL_MIN_SIZE + 1024; ++i) {
+        char record[64];
+        int len = snprintf(record, sizeof(record), "{\"id\": %zu, \"tag\": \"t%zu\"}, ", i, i % 7);
+        json_sb_push(&sb, record, len);
+    }
+    json_sb_push(&sb, "{\"id\": 0}]", 10);
+
+    TEST_CHECK(test_parallel_agrees(sb.data, sb.count, 0, JSON_PARSE_INTERN));
+    TEST_CHECK(test_parallel_agrees(sb.data, sb.count, 0, JSON_PARSE_INTERN | JSON_PARSE_VIEWS));
+    sb_free(&sb);
+    return true;
+}
+
+typedef struct {
+    int64_t id;
+    AliSv name;
+}TestRecord;
+
+// A key that only matches a field name up to an escaped NUL is not that field
+static bool test_decode_nul_key(void) {
+    static const JsonField fields[] = {
+        { "id", offsetof(TestRecord, id), JSON_FIELD_INTEGER, NULL },
+        { "name", offsetof(TestRecord, name), JSON_FIELD_STRING, NULL },
+    };
+    JsonSchema schema = json_schema(fields, 2);
+    const char* content = "{\"id\\u0000xyzwv\": 5, \"name\\u0000\": \"a\", \"id\": 7, \"name\": \"b\"}";
+    AliArena arena = {0};
+    JsonLexer lexer = json_lexer_with_arena(content, strlen(content), &arena);
+    TestRecord record = {0};
+    TEST_CHECK(json_lexer_decode(&lexer, &schema, &record));
+    TEST_CHECK(record.id == 7);
+    TEST_CHECK(record.name.len == 1 && record.name.start[0] == 'b');
+    json_lexer_free(&lexer);
+    ali_arena_free(&arena);
+    return true;
+}
+
+static bool test_format_is(double value, const char* expected) {
+    char out[32];
+    size_t len = json_format_number(out, value);
+    if (len != strlen(expected) || memcmp(out, expected, len) != 0) {
+        printf("%.17g: %.*s, expected %s\n", value, (int)len, out, expected);
+        return false;
+    }
+    return true;
+}
+
+// Subnormals come out as short as normal numbers and parse back exactly
+static bool test_format_subnormal(void) {
+    TEST_CHECK(test_format_is(5e-324, "5e-324"));
+    TEST_CHECK(test_format_is(-1e-323, "-1e-323"));
+    TEST_CHECK(test_format_is(1e-310, "1e-310"));
+    TEST_CHECK(test_format_is(2.225073858507201e-308, "2.225073858507201e-308"));
+    TEST_CHECK(test_format_is(2.2250738585072014e-308, "2.2250738585072014e-308"));
+    TEST_CHECK(test_format_is(1.7976931348623157e308, "1.7976931348623157e308"));
+
+    uint64_t bits = 1;
+    for (int i = 0; i < 100000; ++i) {
+        bits = bits * 6364136223846793005ull + 1442695040888963407ull;
+        uint64_t subnormal = (bits >> 12) | (i % 2 == 0 ? 1 : 0);
+        double value;
+        memcpy(&value, &subnormal, sizeof(value));
+
+        char out[33];
+        size_t len = json_format_number(out, value);
+        out[len] = 0;
+        JsonNumber number;
+        const char* end;
+        TEST_CHECK(json_parse_number(out, out + len, &number, &end) && end == out + len);
+        TEST_CHECK(number.number == value);
+    }
+    return true;
+}
+
+typedef struct {
+    const char* name;
+    bool (*run)(void);
+}Test;
+
+static const Test tests[] = {
+    { "cursor_missing", test_cursor_missing },
+    { "cursor_parse", test_cursor_parse },
+    { "tape_missing", test_tape_missing },
+    { "binary_missing", test_binary_missing },
+    { "string_control_chars", test_string_control_chars },
+    { "validate_agrees", test_validate_agrees },
+    { "number_long_digits", test_number_long_digits },
+    { "parallel_depth", test_parallel_depth },
+    { "parallel_intern", test_parallel_intern },
+    { "decode_nul_key", test_decode_nul_key },
+    { "format_subnormal", test_format_subnormal },
+};
+
+int main(void) {
+    size_t failed = 0;
+    size_t count = sizeof(tests) / sizeof(tests[0]);
+    for (size_t i = 0; i < count; ++i) {
+        bool ok = tests[i].run();
+        printf("%-24s %s\n", tests[i].name, ok ? "ok" : "FAILED");
+        failed += !ok;
+    }
+    printf("%zu of %zu tests passed\n", count - failed, count);
+    return failed == 0 ? 0 : 1;
+}